@@ -0,0 +1,264 @@
+#pragma once
+
+// Frozen Search Tree
+// Written by ItsNorin      https://github.com/ItsNorin/
+
+// an immutable snapshot of sorted keys, laid out as an implicit B-tree for fast searching
+// keys are packed into blocks the size of a cache line, and the children of a block are found by arithmetic,
+// so a search touches one cache line per level with no pointers to follow, and each block is searched
+// without branching, using SSE2 for integer keys of every width, float and double keys
+// other key types are compared one at a time, still without branching
+
+#include <climits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FROZEN_TREE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FROZEN_TREE_BLOCK_BYTES 64 // size of each block of keys, matched to a cache line, must be a multiple of 16
+
+
+// number of keys in a block smaller than key, keys in the block must be sorted
+// the whole block is compared every time, which is cheaper than a branch per key
+template<typename T, unsigned BlockSize, typename = void>
+struct FrozenTreeSearch {
+	static unsigned countLess(const T *keys, const T &key) {
+		unsigned count = 0;
+		for (unsigned i = 0; i < BlockSize; i++)
+			count += (keys[i] < key) ? 1 : 0;
+		return count;
+	}
+};
+
+#ifdef FROZEN_TREE_SSE2
+// sum of the four 32 bit lanes of v
+inline unsigned frozenTreeSum32_(__m128i v) {
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return (unsigned)_mm_cvtsi128_si32(v);
+}
+
+// every comparison sets a lane to -1 where a key is smaller, subtracting those counts them
+// SSE2 only compares signed integers, so unsigned keys have their top bit flipped first, which keeps their order
+template<typename T, unsigned BlockSize, unsigned Bytes = sizeof(T)>
+struct FrozenTreeIntSearch;
+
+template<typename T, unsigned BlockSize>
+struct FrozenTreeIntSearch<T, BlockSize, 1> {
+	static unsigned countLess(const T *keys, const T &key) {
+		const __m128i flip = _mm_set1_epi8(std::is_signed<T>::value ? 0 : SCHAR_MIN);
+		__m128i k = _mm_xor_si128(_mm_set1_epi8((char)key), flip);
+		__m128i count = _mm_setzero_si128();
+		// 8 bit lanes would overflow in a large block, so each compare is summed into 64 bit lanes right away
+		for (unsigned i = 0; i < BlockSize; i += 16) {
+			__m128i less = _mm_cmplt_epi8(_mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i *>(keys + i)), flip), k);
+			count = _mm_add_epi64(count, _mm_sad_epu8(_mm_sub_epi8(_mm_setzero_si128(), less), _mm_setzero_si128()));
+		}
+		return (unsigned)(_mm_cvtsi128_si32(count) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(count, count)));
+	}
+};
+
+template<typename T, unsigned BlockSize>
+struct FrozenTreeIntSearch<T, BlockSize, 2> {
+	static unsigned countLess(const T *keys, const T &key) {
+		const __m128i flip = _mm_set1_epi16(std::is_signed<T>::value ? 0 : SHRT_MIN);
+		__m128i k = _mm_xor_si128(_mm_set1_epi16((short)key), flip);
+		__m128i count = _mm_setzero_si128();
+		for (unsigned i = 0; i < BlockSize; i += 8)
+			count = _mm_sub_epi16(count, _mm_cmplt_epi16(_mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i *>(keys + i)), flip), k));
+		return frozenTreeSum32_(_mm_madd_epi16(count, _mm_set1_epi16(1)));
+	}
+};
+
+template<typename T, unsigned BlockSize>
+struct FrozenTreeIntSearch<T, BlockSize, 4> {
+	static unsigned countLess(const T *keys, const T &key) {
+		const __m128i flip = _mm_set1_epi32(std::is_signed<T>::value ? 0 : INT_MIN);
+		__m128i k = _mm_xor_si128(_mm_set1_epi32((int)key), flip);
+		__m128i count = _mm_setzero_si128();
+		for (unsigned i = 0; i < BlockSize; i += 4)
+			count = _mm_sub_epi32(count, _mm_cmplt_epi32(_mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i *>(keys + i)), flip), k));
+		return frozenTreeSum32_(count);
+	}
+};
+
+// SSE2 has no 64 bit compare, so the high halves are compared, and where they are equal the low halves,
+// which are always unsigned and so always flipped
+template<typename T, unsigned BlockSize>
+struct FrozenTreeIntSearch<T, BlockSize, 8> {
+	static unsigned countLess(const T *keys, const T &key) {
+		const int highFlip = std::is_signed<T>::value ? 0 : INT_MIN;
+		const __m128i flip = _mm_set_epi32(highFlip, INT_MIN, highFlip, INT_MIN);
+		__m128i k = _mm_xor_si128(_mm_set1_epi64x((long long)key), flip);
+		__m128i count = _mm_setzero_si128();
+		for (unsigned i = 0; i < BlockSize; i += 2) {
+			__m128i v = _mm_xor_si128(_mm_load_si128(reinterpret_cast<const __m128i *>(keys + i)), flip);
+			__m128i less = _mm_cmplt_epi32(v, k);
+			__m128i equal = _mm_cmpeq_epi32(v, k);
+			// high lanes become high less, or high equal and low less, then are copied over their low lanes
+			less = _mm_or_si128(less, _mm_and_si128(equal, _mm_shuffle_epi32(less, _MM_SHUFFLE(2, 2, 0, 0))));
+			count = _mm_sub_epi64(count, _mm_shuffle_epi32(less, _MM_SHUFFLE(3, 3, 1, 1)));
+		}
+		return (unsigned)(_mm_cvtsi128_si32(count) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(count, count)));
+	}
+};
+
+template<typename T, unsigned BlockSize>
+struct FrozenTreeSearch<T, BlockSize, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+	: FrozenTreeIntSearch<T, BlockSize> {
+};
+
+template<unsigned BlockSize>
+struct FrozenTreeSearch<float, BlockSize> {
+	static unsigned countLess(const float *keys, const float &key) {
+		__m128 k = _mm_set1_ps(key);
+		__m128i count = _mm_setzero_si128();
+		for (unsigned i = 0; i < BlockSize; i += 4)
+			count = _mm_sub_epi32(count, _mm_castps_si128(_mm_cmplt_ps(_mm_load_ps(keys + i), k)));
+		return frozenTreeSum32_(count);
+	}
+};
+
+template<unsigned BlockSize>
+struct FrozenTreeSearch<double, BlockSize> {
+	static unsigned countLess(const double *keys, const double &key) {
+		__m128d k = _mm_set1_pd(key);
+		__m128i count = _mm_setzero_si128();
+		for (unsigned i = 0; i < BlockSize; i += 2)
+			count = _mm_sub_epi64(count, _mm_castpd_si128(_mm_cmplt_pd(_mm_load_pd(keys + i), k)));
+		return (unsigned)(_mm_cvtsi128_si32(count) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(count, count)));
+	}
+};
+#endif
+
+
+// type must have == and < operators defined
+template<typename T>
+class FrozenTree {
+public:
+	// number of keys in each block
+	static const unsigned BlockSize = (sizeof(T) >= FROZEN_TREE_BLOCK_BYTES) ? 1 : FROZEN_TREE_BLOCK_BYTES / sizeof(T);
+
+protected:
+	// one node of the implicit B-tree, each of its keys is preceded by the child holding the keys smaller than it
+	struct alignas(FROZEN_TREE_BLOCK_BYTES) Block {
+		T keys[BlockSize];
+	};
+
+protected:
+	int size_; // number of elements in tree
+	unsigned blockCount_;
+
+	// blocks of keys, block k's children are blocks k * (BlockSize + 1) + 1 through k * (BlockSize + 1) + BlockSize + 1
+	// slots past the last key are filled with copies of the largest key, so every block is full
+	std::vector<Block> blocks_;
+
+	// index in sorted order of the key in each slot, slot k * BlockSize + i is key i of block k
+	std::vector<int> ranks_;
+
+protected:
+	// i'th child of block k
+	static unsigned child_(unsigned k, unsigned i) { return k * (BlockSize + 1) + i + 1; }
+
+	// fills block k and its children in order from sorted, next is the index of the next key to place
+	void build_(unsigned k, const T sorted[], int &next);
+
+	// slot of the smallest key >= key, -1 if every key is smaller
+	int lowerSlot_(const T &key) const;
+
+public:
+	// create an empty tree
+	FrozenTree();
+
+	// create a tree from a sorted array without duplicates
+	FrozenTree(const T sorted[], const unsigned size);
+
+	// number of elements in tree
+	int size() const;
+
+	// index of given value if found, -1 if not found
+	int find(const T &key) const;
+
+	// number of elements smaller than key, which is also the index key would be inserted at
+	int rank(const T &key) const;
+
+	// smallest element >= key, nullptr if every element is smaller
+	const T * lowerBound(const T &key) const;
+};
+
+
+
+template<typename T>
+inline FrozenTree<T>::FrozenTree()
+	: size_(0), blockCount_(0) {
+}
+
+template<typename T>
+FrozenTree<T>::FrozenTree(const T sorted[], const unsigned size)
+	: size_((int)size), blockCount_((size + BlockSize - 1) / BlockSize),
+	  blocks_(blockCount_), ranks_(blockCount_ * BlockSize) {
+	int next = 0;
+	build_(0, sorted, next);
+}
+
+template<typename T>
+void FrozenTree<T>::build_(unsigned k, const T sorted[], int &next) {
+	if (k >= blockCount_)
+		return;
+
+	for (unsigned i = 0; i < BlockSize; i++) {
+		build_(child_(k, i), sorted, next);
+
+		if (next < size_) {
+			blocks_[k].keys[i] = sorted[next];
+			ranks_[k * BlockSize + i] = next++;
+		}
+		else {
+			blocks_[k].keys[i] = sorted[size_ - 1];
+			ranks_[k * BlockSize + i] = size_;
+		}
+	}
+	build_(child_(k, BlockSize), sorted, next);
+}
+
+
+
+template<typename T>
+inline int FrozenTree<T>::lowerSlot_(const T &key) const {
+	int slot = -1;
+	unsigned k = 0;
+
+	// keys in child i are all smaller than key i, so the last block with a key >= key holds the smallest one
+	while (k < blockCount_) {
+		unsigned i = FrozenTreeSearch<T, BlockSize>::countLess(blocks_[k].keys, key);
+		slot = (i < BlockSize) ? (int)(k * BlockSize + i) : slot;
+		k = child_(k, i);
+	}
+	return slot;
+}
+
+template<typename T>
+inline int FrozenTree<T>::size() const {
+	return size_;
+}
+
+template<typename T>
+inline int FrozenTree<T>::find(const T &key) const {
+	int slot = lowerSlot_(key);
+	return (slot >= 0 && blocks_[slot / BlockSize].keys[slot % BlockSize] == key) ? ranks_[slot] : -1;
+}
+
+template<typename T>
+inline int FrozenTree<T>::rank(const T &key) const {
+	int slot = lowerSlot_(key);
+	return (slot >= 0) ? ranks_[slot] : size_;
+}
+
+template<typename T>
+inline const T * FrozenTree<T>::lowerBound(const T &key) const {
+	int slot = lowerSlot_(key);
+	return (slot >= 0) ? &blocks_[slot / BlockSize].keys[slot % BlockSize] : nullptr;
+}
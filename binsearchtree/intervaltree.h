@@ -0,0 +1,112 @@
+#pragma once
+
+// Interval Tree
+// Written by ItsNorin      https://github.com/ItsNorin/
+
+// a search tree of closed intervals ordered by their start, augmented with the largest end in every subtree,
+// so subtrees that cant overlap a query are skipped without being looked at
+
+#include <limits>
+#include "tree.h"
+
+// closed interval [lo, hi], ordered by lo then hi
+template<typename T>
+struct Interval {
+	T lo, hi;
+
+	Interval(const T &lo = T(), const T &hi = T()) : lo(lo), hi(hi) {}
+
+	// true if the intervals share at least one point
+	bool overlaps(const T &l, const T &h) const { return !(h < lo) && !(hi < l); }
+
+	bool operator==(const Interval &i) const { return lo == i.lo && hi == i.hi; }
+	bool operator!=(const Interval &i) const { return !(*this == i); }
+	bool operator<(const Interval &i) const { return lo < i.lo || (lo == i.lo && hi < i.hi); }
+	bool operator>(const Interval &i) const { return i < *this; }
+	bool operator<=(const Interval &i) const { return !(i < *this); }
+	bool operator>=(const Interval &i) const { return !(*this < i); }
+};
+
+// largest end of a subtree of intervals
+template<typename T>
+struct TreeMaxEnd {
+	typedef T Value;
+	static Value identity() { return std::numeric_limits<T>::lowest(); }
+	static Value of(const Interval<T> &key) { return key.hi; }
+	static Value combine(const Value &a, const Value &b) { return (a < b) ? b : a; }
+};
+
+
+// type must have ==, < operators defined and std::numeric_limits specialized
+template<typename T, typename AllocT = PoolAllocator<Interval<T>>>
+class IntervalTree : public SearchTree<Interval<T>, AllocT, TreeMaxEnd<T>> {
+protected:
+	typedef SearchTree<Interval<T>, AllocT, TreeMaxEnd<T>> Base;
+	typedef typename Base::Node Node;
+
+	template<typename FuncT>
+	static void overlapVisit_(const Node *n_ptr, const T &lo, const T &hi, FuncT &fn);
+
+public:
+	IntervalTree() {}
+	explicit IntervalTree(const AllocT &alloc) : Base(alloc) {}
+
+	using Base::insert;
+	using Base::remove;
+	using Base::find;
+
+	// insert interval [lo, hi], false if it was already in tree
+	bool insert(const T &lo, const T &hi) { return Base::insert(Interval<T>(lo, hi)); }
+
+	// remove interval [lo, hi], false if it wasnt in tree
+	bool remove(const T &lo, const T &hi) { return Base::remove(Interval<T>(lo, hi)); }
+
+	// true if any interval overlaps [lo, hi], O(log n)
+	bool overlaps(const T &lo, const T &hi) const;
+
+	// true if any interval contains point, O(log n)
+	bool stabs(const T &point) const { return overlaps(point, point); }
+
+	// calls fn(const Interval<T> &) on every interval overlapping [lo, hi] in order
+	// O(min(n, k log n)) for k intervals found
+	template<typename FuncT>
+	void overlapVisit(const T &lo, const T &hi, FuncT fn) const { overlapVisit_(this->head_, lo, hi, fn); }
+};
+
+
+
+template<typename T, typename AllocT>
+bool IntervalTree<T, AllocT>::overlaps(const T &lo, const T &hi) const {
+	const Node *n_ptr = this->head_;
+
+	// if the left subtree reaches lo and none of it overlaps, everything in it starts after hi, so the right does too
+	while (n_ptr != nullptr) {
+		if (n_ptr->key.overlaps(lo, hi))
+			return true;
+
+		if (n_ptr->left != nullptr && !(n_ptr->left->aggregate() < lo))
+			n_ptr = n_ptr->left;
+		else
+			n_ptr = n_ptr->right;
+	}
+	return false;
+}
+
+template<typename T, typename AllocT>
+template<typename FuncT>
+void IntervalTree<T, AllocT>::overlapVisit_(const Node *n_ptr, const T &lo, const T &hi, FuncT &fn) {
+	// nothing in a subtree ending before lo can overlap
+	if (n_ptr == nullptr || n_ptr->aggregate() < lo)
+		return;
+
+	overlapVisit_(n_ptr->left, lo, hi, fn);
+
+	// this and everything to the right start after hi
+	if (hi < n_ptr->key.lo)
+		return;
+
+	if (!(n_ptr->key.hi < lo))
+		fn(static_cast<const Interval<T> &>(n_ptr->key));
+
+	overlapVisit_(n_ptr->right, lo, hi, fn);
+}
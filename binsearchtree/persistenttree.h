@@ -0,0 +1,377 @@
+#pragma once
+
+// Persistent Binary Search Tree
+// Written by ItsNorin      https://github.com/ItsNorin/
+
+// an AVL tree where nodes are never changed once made, so any number of threads can read it while it is written to
+// every insert or remove copies the O(log n) nodes on the path it changes, shares the rest of the tree with the
+// previous version, and publishes the new version with a compare and swap
+// readers take a snapshot, which is O(1) and stays the same for as long as they hold it
+// nodes are reference counted, a version is freed once no snapshot or newer version refers to its nodes
+//
+// std::atomic_load on a shared_ptr takes a lock, so the newest version is kept behind a plain atomic pointer instead.
+// readers pin themselves with an EpochReclaimer just long enough to copy its head, and a replaced version is only
+// deleted once no pinned reader can still be copying it, so neither readers nor writers ever wait on a lock
+
+#include <atomic>
+#include <memory>
+#include "../nodepool/epochreclaimer.h"
+
+// type must have == and < operators defined
+template<typename T>
+class PersistentSearchTree {
+protected:
+	class Node;
+	typedef std::shared_ptr<const Node> NodePtr;
+
+	class Node {
+	public:
+		T key;
+		NodePtr left, right;
+
+		int height; // height of node
+		int count;  // number of nodes in subtree, including this one
+
+		Node(const NodePtr &left, const T &key, const NodePtr &right)
+			: key(key), left(left), right(right),
+			  height(((height_(left) > height_(right)) ? height_(left) : height_(right)) + 1),
+			  count(count_(left) + count_(right) + 1) {
+		}
+	};
+
+public:
+	// an immutable version of the tree
+	// cheap to copy, and safe to use from any thread while the tree keeps changing
+	class Snapshot {
+		friend class PersistentSearchTree;
+
+		protected:
+			NodePtr head_;
+
+			Snapshot(const NodePtr &head) : head_(head) {}
+
+		public:
+			Snapshot() {}
+
+			// number of elements in snapshot
+			int size() const { return count_(head_); }
+
+			// index of given value if found, -1 if not found
+			int find(const T &key) const;
+
+			// true if key is in snapshot
+			bool contains(const T &key) const { return find(key) >= 0; }
+
+			// access a given element, elements are indexed in sorted order
+			const T & operator[](const unsigned i) const;
+
+			// calls fn(const T &) on every element in order
+			template<typename FuncT>
+			void forEach(FuncT fn) const { forEach_(head_.get(), fn); }
+	};
+
+public:
+	// initialize a tree
+	PersistentSearchTree();
+
+	PersistentSearchTree(const PersistentSearchTree &tree) = delete;
+	PersistentSearchTree & operator=(const PersistentSearchTree &tree) = delete;
+
+	// no other thread may be using the tree, snapshots stay valid
+	~PersistentSearchTree();
+
+	// current version of the tree, O(1)
+	Snapshot snapshot() const;
+
+	// number of elements in tree
+	int size() const;
+
+	// insert element into tree
+	// false if key already exists in tree, element was not inserted
+	// true if successful
+	// writers dont block each other or readers, if two race the loser redoes its insert on the winner's version
+	bool insert(const T &key);
+
+	// removes an element from tree
+	// false if key not found, true if removed
+	bool remove(const T &key);
+
+	// delete all elements in tree, existing snapshots keep theirs
+	void clear();
+
+	// index of given value if found, -1 if not found
+	int find(const T &key) const;
+
+protected:
+	// a published version of the tree
+	struct Version {
+		NodePtr head;
+		Version *retiredNext; // link while waiting to be freed
+
+		Version(const NodePtr &head) : head(head), retiredNext(nullptr) {}
+	};
+
+protected:
+	// newest version, never nullptr, replaced ones are retired to reclaimer_
+	std::atomic<Version *> version_;
+	mutable EpochReclaimer<Version> reclaimer_;
+
+protected:
+	static int height_(const NodePtr &n_ptr) { return (n_ptr == nullptr) ? -1 : n_ptr->height; }
+	static int count_(const NodePtr &n_ptr) { return (n_ptr == nullptr) ? 0 : n_ptr->count; }
+
+	// new node holding key above l and r, rotating if their heights differ by more than 1
+	static NodePtr balance_(const NodePtr &l, const T &key, const NodePtr &r);
+
+	// copy of the path to key with key inserted, returns n_ptr itself if key was already there
+	static NodePtr insert_(const NodePtr &n_ptr, const T &key, bool &inserted);
+
+	// copy of the path to key with key removed, returns n_ptr itself if key wasnt there
+	static NodePtr remove_(const NodePtr &n_ptr, const T &key, bool &removed);
+
+	// copy of the path to the smallest element with it removed, its key is written to min
+	static NodePtr removeMin_(const NodePtr &n_ptr, T &min);
+
+	template<typename FuncT>
+	static void forEach_(const Node *n_ptr, FuncT &fn);
+
+	// head of the newest version
+	NodePtr head_() const;
+
+	// publishes head as the new version if expected, the version it was made from, is still the newest
+	// otherwise fails and sets expected to the newest version
+	// versions that can now be freed are added to freed
+	bool publish_(typename EpochReclaimer<Version>::Guard &guard, Version *&expected, const NodePtr &head, Version *&freed);
+
+	// frees a list of versions linked through retiredNext
+	static void deleteRetired_(Version *version);
+};
+
+
+
+template<typename T>
+inline int PersistentSearchTree<T>::Snapshot::find(const T &key) const {
+	const Node *n_ptr = head_.get();
+	int index = 0;
+
+	while (n_ptr != nullptr) {
+		if (n_ptr->key == key)
+			return index + count_(n_ptr->left);
+
+		if (key < n_ptr->key)
+			n_ptr = n_ptr->left.get();
+		else {
+			index += count_(n_ptr->left) + 1;
+			n_ptr = n_ptr->right.get();
+		}
+	}
+	return -1;
+}
+
+template<typename T>
+inline const T & PersistentSearchTree<T>::Snapshot::operator[](const unsigned i) const {
+	const Node *n_ptr = head_.get();
+	int index = (int)i;
+
+	while (true) {
+		int left = count_(n_ptr->left);
+		if (index == left)
+			return n_ptr->key;
+
+		if (index < left)
+			n_ptr = n_ptr->left.get();
+		else {
+			index -= left + 1;
+			n_ptr = n_ptr->right.get();
+		}
+	}
+}
+
+template<typename T>
+template<typename FuncT>
+void PersistentSearchTree<T>::forEach_(const Node *n_ptr, FuncT &fn) {
+	if (n_ptr == nullptr)
+		return;
+	forEach_(n_ptr->left.get(), fn);
+	fn(n_ptr->key);
+	forEach_(n_ptr->right.get(), fn);
+}
+
+
+
+template<typename T>
+typename PersistentSearchTree<T>::NodePtr PersistentSearchTree<T>::balance_(const NodePtr &l, const T &key, const NodePtr &r) {
+	if (height_(l) > height_(r) + 1) {
+		if (height_(l->left) >= height_(l->right))
+			return std::make_shared<const Node>(l->left, l->key, std::make_shared<const Node>(l->right, key, r));
+
+		const NodePtr &lr = l->right;
+		return std::make_shared<const Node>(
+			std::make_shared<const Node>(l->left, l->key, lr->left), lr->key, std::make_shared<const Node>(lr->right, key, r));
+	}
+	if (height_(r) > height_(l) + 1) {
+		if (height_(r->right) >= height_(r->left))
+			return std::make_shared<const Node>(std::make_shared<const Node>(l, key, r->left), r->key, r->right);
+
+		const NodePtr &rl = r->left;
+		return std::make_shared<const Node>(
+			std::make_shared<const Node>(l, key, rl->left), rl->key, std::make_shared<const Node>(rl->right, r->key, r->right));
+	}
+	return std::make_shared<const Node>(l, key, r);
+}
+
+template<typename T>
+typename PersistentSearchTree<T>::NodePtr PersistentSearchTree<T>::insert_(const NodePtr &n_ptr, const T &key, bool &inserted) {
+	if (n_ptr == nullptr) {
+		inserted = true;
+		return std::make_shared<const Node>(nullptr, key, nullptr);
+	}
+	if (n_ptr->key == key) {
+		inserted = false;
+		return n_ptr;
+	}
+
+	if (key < n_ptr->key) {
+		NodePtr l = insert_(n_ptr->left, key, inserted);
+		return inserted ? balance_(l, n_ptr->key, n_ptr->right) : n_ptr;
+	}
+	NodePtr r = insert_(n_ptr->right, key, inserted);
+	return inserted ? balance_(n_ptr->left, n_ptr->key, r) : n_ptr;
+}
+
+template<typename T>
+typename PersistentSearchTree<T>::NodePtr PersistentSearchTree<T>::removeMin_(const NodePtr &n_ptr, T &min) {
+	if (n_ptr->left == nullptr) {
+		min = n_ptr->key;
+		return n_ptr->right;
+	}
+	return balance_(removeMin_(n_ptr->left, min), n_ptr->key, n_ptr->right);
+}
+
+template<typename T>
+typename PersistentSearchTree<T>::NodePtr PersistentSearchTree<T>::remove_(const NodePtr &n_ptr, const T &key, bool &removed) {
+	if (n_ptr == nullptr) {
+		removed = false;
+		return n_ptr;
+	}
+
+	if (n_ptr->key == key) {
+		removed = true;
+		if (n_ptr->left == nullptr)
+			return n_ptr->right;
+		if (n_ptr->right == nullptr)
+			return n_ptr->left;
+
+		// two children, the successor takes its place
+		T min = n_ptr->key;
+		NodePtr r = removeMin_(n_ptr->right, min);
+		return balance_(n_ptr->left, min, r);
+	}
+
+	if (key < n_ptr->key) {
+		NodePtr l = remove_(n_ptr->left, key, removed);
+		return removed ? balance_(l, n_ptr->key, n_ptr->right) : n_ptr;
+	}
+	NodePtr r = remove_(n_ptr->right, key, removed);
+	return removed ? balance_(n_ptr->left, n_ptr->key, r) : n_ptr;
+}
+
+
+
+template<typename T>
+inline PersistentSearchTree<T>::PersistentSearchTree() : version_(new Version(NodePtr())) {
+}
+
+template<typename T>
+PersistentSearchTree<T>::~PersistentSearchTree() {
+	deleteRetired_(reclaimer_.drain());
+	delete version_.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+void PersistentSearchTree<T>::deleteRetired_(Version *version) {
+	while (version != nullptr) {
+		Version *temp = version;
+		version = version->retiredNext;
+		delete temp;
+	}
+}
+
+template<typename T>
+inline typename PersistentSearchTree<T>::NodePtr PersistentSearchTree<T>::head_() const {
+	// the version cant be deleted while pinned, copying its head keeps the nodes alive after that
+	typename EpochReclaimer<Version>::Guard guard = reclaimer_.pin();
+	return version_.load(std::memory_order_acquire)->head;
+}
+
+template<typename T>
+inline typename PersistentSearchTree<T>::Snapshot PersistentSearchTree<T>::snapshot() const {
+	return Snapshot(head_());
+}
+
+template<typename T>
+inline int PersistentSearchTree<T>::size() const {
+	return count_(head_());
+}
+
+template<typename T>
+inline int PersistentSearchTree<T>::find(const T &key) const {
+	return snapshot().find(key);
+}
+
+template<typename T>
+bool PersistentSearchTree<T>::publish_(typename EpochReclaimer<Version>::Guard &guard, Version *&expected, const NodePtr &head, Version *&freed) {
+	Version *version = new Version(head);
+	if (!version_.compare_exchange_strong(expected, version, std::memory_order_acq_rel, std::memory_order_acquire)) {
+		delete version;
+		return false;
+	}
+	freed = reclaimer_.retire(guard, expected);
+	return true;
+}
+
+template<typename T>
+bool PersistentSearchTree<T>::insert(const T &key) {
+	Version *freed = nullptr;
+	bool inserted;
+	{
+		// pinned for the whole loop, so every version loaded stays readable while the new one is made from it
+		typename EpochReclaimer<Version>::Guard guard = reclaimer_.pin();
+		Version *version = version_.load(std::memory_order_acquire);
+		for (;;) {
+			NodePtr newHead = insert_(version->head, key, inserted);
+			if (!inserted || publish_(guard, version, newHead, freed))
+				break;
+		}
+	}
+	deleteRetired_(freed);
+	return inserted;
+}
+
+template<typename T>
+bool PersistentSearchTree<T>::remove(const T &key) {
+	Version *freed = nullptr;
+	bool removed;
+	{
+		typename EpochReclaimer<Version>::Guard guard = reclaimer_.pin();
+		Version *version = version_.load(std::memory_order_acquire);
+		for (;;) {
+			NodePtr newHead = remove_(version->head, key, removed);
+			if (!removed || publish_(guard, version, newHead, freed))
+				break;
+		}
+	}
+	deleteRetired_(freed);
+	return removed;
+}
+
+template<typename T>
+inline void PersistentSearchTree<T>::clear() {
+	Version *freed;
+	{
+		typename EpochReclaimer<Version>::Guard guard = reclaimer_.pin();
+		Version *version = version_.exchange(new Version(NodePtr()), std::memory_order_acq_rel);
+		freed = reclaimer_.retire(guard, version);
+	}
+	deleteRetired_(freed);
+}
@@ -3,11 +3,33 @@
 // Binary Search Tree
 // Written by ItsNorin      https://github.com/ItsNorin/
 
-// an ALV tree optimized for quick searching O(log n) and accessing of elements O(1)
+// an ALV tree optimized for quick searching O(log n) and accessing of elements by index O(log n)
+// every node knows the size of its subtree, so an element's index and the element at an index
+// are both found on the way down from the head
 
+#include <algorithm>
+#include <future>
 #include <initializer_list>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "frozentree.h"
+#include "treeaugment.h"
+#include "../nodepool/nodepool.h"
+
+#define TREE_PARALLEL_THRESHOLD 65536 // subtrees larger than this are split between threads when bulk loading or combining trees
 
 // #define TREE_PRINTING // uncomment to be able to print tree in console with std::cout
+// #define TREE_STATS // uncomment to count the rotations and nodes retraced by insert and remove
+
+#ifdef TREE_STATS
+#define TREE_COUNT_(counter) (++stats_.counter)
+#else
+#define TREE_COUNT_(counter)
+#endif
 
 #ifdef TREE_PRINTING
 #define LEAF_SPACING 5
@@ -20,45 +42,67 @@ template<typename T> T max(const T &a, const T &b) { return (a > b) ? a : b; }
 
 // type must have ==, >=, >, <, <= operators defined
 // if TREE_PRINTING is defined, must also be printable with std::cout <<
-template<typename T>
+// nodes come from AllocT rebound to the node type, a NodePool by default, std::pmr::polymorphic_allocator works too
+// AugmentT keeps an aggregate of every subtree, see treeaugment.h, range aggregates are then O(log n)
+template<typename T, typename AllocT = PoolAllocator<T>, typename AugmentT = TreeNoAugment<T>>
 class SearchTree {
+public:
+	typedef typename AugmentT::Value AggregateT;
+
 protected:
-	class Node {
+	class Node : public TreeAggregateSlot<AggregateT> {
 	public:
 		T key;
 
 		Node *left, *right,
 			 *parent;
 		
-		int index;  // node's index in the referance array
 		int height; // height of node
+		int count;  // number of nodes in subtree, including this one
 
 		Node(const T key = T(), Node *parent = nullptr) 
-			: key(key), left(nullptr), right(nullptr), parent(parent), height(0) {
+			: key(key), left(nullptr), right(nullptr), parent(parent), height(0), count(1) {
 		}
 	};
 
+	typedef typename std::allocator_traits<AllocT>::template rebind_alloc<Node> NodeAllocT;
+	typedef std::allocator_traits<NodeAllocT> NodeTraits;
+
+public:
+	class Iterator;
+
 protected:
+	NodeAllocT alloc_;
 	Node *head_; // head of tree
-	Node **arr_; // array representation of tree
+	Node **arr_; // array representation of tree, only up to date while arrValid_
 	int size_;   // number of elements in tree
 	bool arrValid_;
 
 protected:
-	// number of children a node has
-	static int numChildren_(const Node *n_ptr);
+	// search the tree for given element, returns index
+	int find_(const T &key) const;
+
+	// node at given index
+	Node * select_(int i) const;
+
+	// number of elements smaller than key, or also equal to it if orEqual
+	int countBelow_(const T &key, bool orEqual) const;
+
+	// first node with a key >= key, or > key if strictly, nullptr if none
+	Node * lowerNode_(const T &key, bool strictly) const;
 
-	// increments count by number of nodes below this node
-	static void addChildren_(const Node *n_ptr, int &count);
+	// smallest and largest nodes in a subtree
+	static Node * first_(Node *n_ptr);
+	static Node * last_(Node *n_ptr);
 
-	// search the node and its children for given element, returns index
-	// todo: try to optimize for minimal memory usage
-	static int find_(const T &d, const Node *n_ptr);
+	// next and previous nodes in order, nullptr past either end
+	static Node * successor_(Node *n_ptr);
+	static Node * predecessor_(Node *n_ptr);
 
 	// creates an array from node and its children, returns size
 	int generateArr_(Node **&arr);
 
-	// adds all children to given array
+	// adds a node and all its children to given array in order, starting at index i, returns index after the last
 	static int addToArr_(Node *n_ptr, Node **&arr, int i);
 	
 	// height of a node
@@ -72,6 +116,28 @@ protected:
 		return n_ptr->height;
 	}
 
+	// number of nodes in a subtree
+	static int count_(const Node *n_ptr) {
+		return (n_ptr == nullptr) ? 0 : n_ptr->count;
+	}
+
+	// aggregate of a subtree
+	static AggregateT aggregate_(const Node *n_ptr) {
+		return (n_ptr == nullptr) ? AugmentT::identity() : n_ptr->aggregate();
+	}
+
+	// sets a node's subtree size and aggregate from its children
+	static void updateCount_(Node *n_ptr) {
+		n_ptr->count = count_(n_ptr->left) + count_(n_ptr->right) + 1;
+		n_ptr->aggregate(AugmentT::combine(AugmentT::combine(aggregate_(n_ptr->left), AugmentT::of(n_ptr->key)), aggregate_(n_ptr->right)));
+	}
+
+	// sets a node's height, subtree size and aggregate from its children
+	static void update_(Node *n_ptr) {
+		calcHeight_(n_ptr);
+		updateCount_(n_ptr);
+	}
+
 	// how balanced the subtree is, positive is right heavy, negative left heavy
 	static int balanceFactor_(const Node *n_ptr) { 
 		return height_(n_ptr->right) - height_(n_ptr->left);  
@@ -83,18 +149,93 @@ protected:
 	// rotates subtree left, returns new parent
 	static Node * rotateLeft_(Node *root); 
 
-	// balances a subtree
+	// rebalances from n_ptr up to the head after a node below it was added or removed
+	// stops rotating once a subtree's height is unchanged, above that only sizes and aggregates are updated
 	void balanceSubtree_(Node *n_ptr);
 
+	// allocates and constructs a node
+	Node * newNode_(const T &key, Node *parent = nullptr);
+
+	// destroys a node and gives its memory back
+	void deleteNode_(Node *n_ptr);
+
+	// deletes every node in a subtree
+	void destroy_(Node *n_ptr);
+
+	// adds every node in a subtree to nodes
+	static void collect_(Node *n_ptr, std::vector<Node *> &nodes);
+
+	// copies a subtree, keeping its shape
+	Node * copy_(const Node *n_ptr, Node *parent);
+
+	// sorts arr and removes duplicates, then builds the tree from it
+	void load_(std::vector<T> &arr);
+
+	// how many levels of the bulk recursions below may split work between threads, about log2 of the hardware threads
+	// each level doubles the threads, so at most about one per hardware thread is ever running
+	static int parallelDepth_();
+
+	// runs fn on a new thread, or on the calling thread once its result is asked for if no thread could be started
+	template<typename FuncT>
+	static auto async_(FuncT fn) -> std::future<decltype(fn())>;
+
+	// sorts a range, halves of large ranges are sorted in parallel and merged while depth is left
+	static void sort_(T *begin, T *end, int depth);
+
+	// links already made nodes, in sorted order without duplicates, into a perfectly balanced subtree, returns its root
+	// allocating every node beforehand lets large subtrees be linked in parallel with any allocator
+	static Node * build_(Node *const *nodes, int size, int depth);
+
+	// makes n the root of l and r, sets its height and size, returns n
+	// every key in l must be smaller than n's, and every key in r larger
+	static Node * link_(Node *l, Node *n, Node *r);
+
+	// link_, for subtrees of any heights, rebalancing where they meet, returns the new root
+	static Node * join_(Node *l, Node *n, Node *r);
+
+	// join_ where l is taller than r, r is joined into l's right spine
+	static Node * joinRight_(Node *l, Node *n, Node *r);
+
+	// join_ where r is taller than l, l is joined into r's left spine
+	static Node * joinLeft_(Node *l, Node *n, Node *r);
+
+	// joins two subtrees with no node between them, every key in l must be smaller than every key in r
+	static Node * join2_(Node *l, Node *r);
+
+	// splits a subtree into the keys smaller than key, l, and larger than key, r
+	// returns the node holding key, unlinked from both, or nullptr if there is none
+	static Node * split_(Node *n_ptr, const T &key, Node *&l, Node *&r);
+
+	// splits the largest node off a subtree, returns the rest
+	static Node * splitLast_(Node *n_ptr, Node *&last);
+
+	// combine two subtrees into one, using up the nodes of both, returns the new root
+	// nodes left over are added to garbage instead of deleted, so large subtrees can have their halves combined
+	// in parallel without sharing the allocator between threads, for as many levels as depth allows
+	static Node * unite_(Node *a, Node *b, std::vector<Node *> &garbage, int depth);
+	static Node * intersect_(Node *a, Node *b, std::vector<Node *> &garbage, int depth);
+	static Node * subtract_(Node *a, Node *b, std::vector<Node *> &garbage, int depth);
+
+	// deletes every node in garbage
+	void deleteNodes_(std::vector<Node *> &garbage);
+
 public:
 	// initialize a tree
 	SearchTree();
 
+	// initialize a tree allocating its nodes with alloc
+	explicit SearchTree(const AllocT &alloc);
+
 	// create a tree from an initializer list
-	SearchTree(const std::initializer_list<T> &list);
+	SearchTree(const std::initializer_list<T> &list, const AllocT &alloc = AllocT());
 
 	// create a tree from an array
-	SearchTree(const T arr[], const unsigned size);
+	// the array is sorted unless it already is, duplicates are dropped, and the tree is built balanced in one pass
+	SearchTree(const T arr[], const unsigned size, const AllocT &alloc = AllocT());
+
+	// copy an existing tree
+	SearchTree(const SearchTree &tree);
+	SearchTree & operator=(const SearchTree &tree);
 
 	~SearchTree();
 
@@ -116,10 +257,69 @@ public:
 	// index of given value if found, -1 if not found
 	int find(const T key) const;
 
-	// access a given element in tree
-	// order will likely change when an element is inserted or deleted
-	T & operator[](const unsigned i) { return arr_[i]->key; }
-	T operator[](const unsigned i) const { return arr_[i]->key; }
+	// adds every element of tree to this one
+	// O(m log(n/m + 1)) for the smaller tree's m elements and the larger tree's n, plus copying tree
+	void unite(const SearchTree &tree);
+
+	// removes every element not in tree
+	void intersect(const SearchTree &tree);
+
+	// removes every element in tree
+	void subtract(const SearchTree &tree);
+
+	// iterator pointing to smallest element of tree
+	Iterator start() const;
+	// iterator pointing to end + 1 of tree
+	Iterator end() const;
+
+	// iterator to the first element >= key, end() if none
+	Iterator lowerBound(const T &key) const;
+	// iterator to the first element > key, end() if none
+	Iterator upperBound(const T &key) const;
+	// lowerBound and upperBound of key, the range of elements equal to it
+	std::pair<Iterator, Iterator> equalRange(const T &key) const;
+
+	// calls fn(const T &) on every element in [lo, hi] in order, visiting O(log n + k) nodes for k elements
+	template<typename FuncT>
+	void rangeVisit(const T &lo, const T &hi, FuncT fn) const;
+
+	// number of elements in [lo, hi], O(log n)
+	int countInRange(const T &lo, const T &hi) const;
+
+	// AugmentT's aggregate of every element, O(1)
+	AggregateT aggregate() const;
+	// AugmentT's aggregate of every element in [lo, hi], combined in order, O(log n)
+	AggregateT aggregate(const T &lo, const T &hi) const;
+
+	// access a given element in tree, elements are indexed in sorted order
+	// O(log n), or O(1) while the array built by buildArray() is still valid
+	T & operator[](const unsigned i) { return arrValid_ ? arr_[i]->key : select_(i)->key; }
+	T operator[](const unsigned i) const { return arrValid_ ? arr_[i]->key : select_(i)->key; }
+
+	// builds an array of every node in order, making access by index O(1) until the tree next changes
+	// worth it for read heavy phases that index the tree a lot
+	void buildArray();
+
+	// immutable copy of the tree laid out as an implicit B-tree, searching it reads a cache line per block of keys
+	// instead of one per node, worth it for read only phases
+	FrozenTree<T> freeze() const;
+
+#ifdef TREE_STATS
+public:
+	// work done by insert and remove since the tree was made or resetStats() was called
+	struct Stats {
+		unsigned long long operations; // inserts and removes that changed the tree
+		unsigned long long rotations;  // single rotations, a double rotation counts as two
+		unsigned long long retraced;   // nodes whose height and balance were checked on the way up
+		unsigned long long updated;    // nodes above the early exit that only had their size and aggregate updated
+	};
+
+	const Stats & stats() const { return stats_; }
+	void resetStats() { stats_ = Stats(); }
+
+protected:
+	Stats stats_ = Stats();
+#endif // TREE_STATS
 
 #ifdef TREE_PRINTING
 protected:
@@ -133,47 +333,81 @@ public:
 };
 
 
+// in order iterator for search trees
+// elements cant be changed through it, that could break the tree's order
+// stays valid while its element is in the tree
+template<typename T, typename AllocT, typename AugmentT>
+class SearchTree<T, AllocT, AugmentT>::Iterator {
+	protected:
+		Node *it_;
+		const SearchTree *tree_; // needed to step back from end()
 
-template<typename T>
-void SearchTree<T>::addChildren_(const Node *n_ptr, int &count) {
-	count++;
-	if (n_ptr->left != nullptr)
-		addChildren_(n_ptr->left, count);
-	if (n_ptr->right != nullptr)
-		addChildren_(n_ptr->right, count);
-}
+	public:
+		Iterator() : it_(nullptr), tree_(nullptr) {}
+		Iterator(Node *ptr, const SearchTree *tree) : it_(ptr), tree_(tree) {}
 
-template<typename T>
-inline int SearchTree<T>::numChildren_(const Node *n_ptr) {
-	int c = 0;
-	addChildren_(n_ptr, c);
-	return c;
-}
+		// advance iterator
+		Iterator next() const { return Iterator(successor_(it_), tree_); }
+		// move iterator back, from end() moves to the largest element
+		Iterator prev() const { return Iterator((it_ == nullptr) ? last_(tree_->head_) : predecessor_(it_), tree_); }
 
+		Iterator & operator++();
+		Iterator operator++(int);
 
+		Iterator & operator--();
+		Iterator operator--(int);
 
-template<typename T>
-int SearchTree<T>::addToArr_(Node *n_ptr, Node **&arr, int i) {
-	if (n_ptr == nullptr)
-		return i;
+		// dereferance iterator
+		const T & operator*() const { return it_->key; }
+		const T * operator->() const { return &it_->key; }
 
-	if (n_ptr->left != nullptr)
-		i = addToArr_(n_ptr->left, arr, i);
+		bool operator==(const Iterator &it) const { return this->it_ == it.it_; }
+		bool operator!=(const Iterator &it) const { return this->it_ != it.it_; }
+};
 
-	arr[i] = n_ptr;
-	n_ptr->index = i;
-	++i;
 
-	if (n_ptr->right != nullptr)
-		i = addToArr_(n_ptr->right, arr, i);
 
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator & SearchTree<T, AllocT, AugmentT>::Iterator::operator++() {
+	it_ = successor_(it_);
+	return *this;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator SearchTree<T, AllocT, AugmentT>::Iterator::operator++(int) {
+	Iterator temp = *this;
+	++*this;
+	return temp;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator & SearchTree<T, AllocT, AugmentT>::Iterator::operator--() {
+	*this = prev();
+	return *this;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator SearchTree<T, AllocT, AugmentT>::Iterator::operator--(int) {
+	Iterator temp = *this;
+	--*this;
+	return temp;
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+int SearchTree<T, AllocT, AugmentT>::addToArr_(Node *n_ptr, Node **&arr, int i) {
+	// follows parent links, so no stack is needed, the subtree's size says when to stop before leaving it
+	int end = i + count_(n_ptr);
+	for (n_ptr = first_(n_ptr); i < end; n_ptr = successor_(n_ptr))
+		arr[i++] = n_ptr;
 	return i;
 }
 
 
 
-template<typename T>
-typename SearchTree<T>::Node *SearchTree<T>::rotateRight_(Node *root) {
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node *SearchTree<T, AllocT, AugmentT>::rotateRight_(Node *root) {
 	Node *newRoot = root->left;
 	newRoot->parent = root->parent;
 	root->left = newRoot->right;
@@ -191,14 +425,14 @@ typename SearchTree<T>::Node *SearchTree<T>::rotateRight_(Node *root) {
 			newRoot->parent->left = newRoot;
 	}
 
-	calcHeight_(root);
-	calcHeight_(newRoot);
+	update_(root);
+	update_(newRoot);
 
 	return newRoot;
 }
 
-template<typename T>
-typename SearchTree<T>::Node * SearchTree<T>::rotateLeft_(Node *root) {
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::rotateLeft_(Node *root) {
 	Node *newRoot = root->right;
 	newRoot->parent = root->parent;
 	root->right = newRoot->left;
@@ -216,60 +450,91 @@ typename SearchTree<T>::Node * SearchTree<T>::rotateLeft_(Node *root) {
 			newRoot->parent->left = newRoot;
 	}
 
-	calcHeight_(root);
-	calcHeight_(newRoot);
+	update_(root);
+	update_(newRoot);
 
 	return newRoot;
 }
 
-template<typename T>
-void SearchTree<T>::balanceSubtree_(Node * n_ptr) {
-	calcHeight_(n_ptr);
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::balanceSubtree_(Node * n_ptr) {
+	bool heightChanged = true;
 
-	int balance = balanceFactor_(n_ptr);
+	while (n_ptr != nullptr && heightChanged) {
+		TREE_COUNT_(retraced);
+		int oldHeight = n_ptr->height;
+		update_(n_ptr);
 
-	if (balance < -1) {
-		if (height_(n_ptr->left->left) >= height_(n_ptr->left->right)) {
-			n_ptr = rotateRight_(n_ptr);
-		}
-		else {
-			n_ptr->left = rotateLeft_(n_ptr->left);
+		int balance = balanceFactor_(n_ptr);
+
+		if (balance < -1) {
+			if (height_(n_ptr->left->left) < height_(n_ptr->left->right)) {
+				n_ptr->left = rotateLeft_(n_ptr->left);
+				TREE_COUNT_(rotations);
+			}
 			n_ptr = rotateRight_(n_ptr);
+			TREE_COUNT_(rotations);
 		}
-	}
-	else if (balance > 1) {
-		if (height_(n_ptr->right->right) >= height_(n_ptr->right->left)) {
-			n_ptr = rotateLeft_(n_ptr);
-		}
-		else {
-			n_ptr->right = rotateRight_(n_ptr->right);
+		else if (balance > 1) {
+			if (height_(n_ptr->right->right) < height_(n_ptr->right->left)) {
+				n_ptr->right = rotateRight_(n_ptr->right);
+				TREE_COUNT_(rotations);
+			}
 			n_ptr = rotateLeft_(n_ptr);
+			TREE_COUNT_(rotations);
 		}
+
+		if (n_ptr->parent == nullptr)
+			head_ = n_ptr;
+
+		// a subtree as tall as before cant unbalance anything above it
+		heightChanged = n_ptr->height != oldHeight;
+		n_ptr = n_ptr->parent;
 	}
 
-	if (n_ptr->parent != nullptr) {
-		balanceSubtree_(n_ptr->parent);
+	for (; n_ptr != nullptr; n_ptr = n_ptr->parent) {
+		TREE_COUNT_(updated);
+		updateCount_(n_ptr);
 	}
-	else
-		head_ = n_ptr;
 }
 
-template<typename T>
-inline SearchTree<T>::SearchTree() 
-	: size_(0), head_(nullptr), arr_(nullptr), arrValid_(false) {
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT>::SearchTree() 
+	: alloc_(AllocT()), head_(nullptr), arr_(nullptr), size_(0), arrValid_(false) {
 }
 
-template<typename T>
-inline SearchTree<T>::SearchTree(const std::initializer_list<T>& list)
-	: size_(0), head_(nullptr), arr_(nullptr), arrValid_(false) {
-	for (unsigned i = 0; i < list.size(); i++)
-		insert(list.begin()[i]);
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT>::SearchTree(const AllocT &alloc) 
+	: alloc_(alloc), head_(nullptr), arr_(nullptr), size_(0), arrValid_(false) {
 }
 
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT>::SearchTree(const std::initializer_list<T>& list, const AllocT &alloc)
+	: alloc_(alloc), head_(nullptr), arr_(nullptr), size_(0), arrValid_(false) {
+	std::vector<T> arr(list.begin(), list.end());
+	load_(arr);
+}
 
-template<typename T>
-inline int SearchTree<T>::generateArr_(Node **&arr) {
-	int size = numChildren_(head_);
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT>::SearchTree(const SearchTree &tree)
+	: alloc_(NodeTraits::select_on_container_copy_construction(tree.alloc_)), head_(nullptr), arr_(nullptr), size_(tree.size_), arrValid_(false) {
+	head_ = copy_(tree.head_, nullptr);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT> & SearchTree<T, AllocT, AugmentT>::operator=(const SearchTree &tree) {
+	if (this != &tree) {
+		clear();
+		head_ = copy_(tree.head_, nullptr);
+		size_ = tree.size_;
+	}
+	return *this;
+}
+
+
+template<typename T, typename AllocT, typename AugmentT>
+inline int SearchTree<T, AllocT, AugmentT>::generateArr_(Node **&arr) {
+	int size = count_(head_);
 	if (arr != nullptr)
 		delete[] arr;
 	arr = new Node*[size];
@@ -277,11 +542,19 @@ inline int SearchTree<T>::generateArr_(Node **&arr) {
 	return size;
 }
 
+template<typename T, typename AllocT, typename AugmentT>
+inline void SearchTree<T, AllocT, AugmentT>::buildArray() {
+	if (!arrValid_) {
+		generateArr_(arr_);
+		arrValid_ = true;
+	}
+}
+
 
-template<typename T>
-inline bool SearchTree<T>::insert(const T key) {
+template<typename T, typename AllocT, typename AugmentT>
+inline bool SearchTree<T, AllocT, AugmentT>::insert(const T key) {
 	if (head_ == nullptr)
-		head_ = new Node(key);
+		head_ = newNode_(key);
 	else {
 		Node *n_ptr = head_, 
 			 *n_prev = nullptr;
@@ -298,9 +571,9 @@ inline bool SearchTree<T>::insert(const T key) {
 
 			if (n_ptr == nullptr) {
 				if (goLeft) 
-					n_prev->left = new Node(key, n_prev);
+					n_prev->left = newNode_(key, n_prev);
 				else 
-					n_prev->right = new Node(key, n_prev);
+					n_prev->right = newNode_(key, n_prev);
 				
 				balanceSubtree_(n_prev);
 				run = false;
@@ -308,84 +581,701 @@ inline bool SearchTree<T>::insert(const T key) {
 		}
 	}
 
-	size_ = generateArr_(arr_);
+	++size_;
+	arrValid_ = false;
+	TREE_COUNT_(operations);
 
 	return true;
 }
 
-template<typename T>
-bool SearchTree<T>::remove(const T key) {
-	if (head_ != nullptr) {
-		Node *n_ptr = head_, *parent = head_, *child = head_;
-		Node *delNode = nullptr;
-			
-		while (child != nullptr) {
-			parent = n_ptr;
-			n_ptr = child;
-			child = (key >= n_ptr->key) ? n_ptr->right : n_ptr->left;
-			if (key == n_ptr->key)
-				delNode = n_ptr;
+template<typename T, typename AllocT, typename AugmentT>
+bool SearchTree<T, AllocT, AugmentT>::remove(const T key) {
+	Node *delNode = head_;
+	while (delNode != nullptr && !(delNode->key == key))
+		delNode = (key < delNode->key) ? delNode->left : delNode->right;
+
+	if (delNode == nullptr)
+		return false;
+
+	// a node with two children is replaced by its successor node, not its successor's key,
+	// so iterators to the successor stay valid. retracing starts where the tree lost a node
+	Node *child, *retrace;
+	if (delNode->left != nullptr && delNode->right != nullptr) {
+		child = first_(delNode->right);
+		retrace = child;
+
+		if (child->parent != delNode) {
+			retrace = child->parent;
+			retrace->left = child->right;
+			if (child->right != nullptr)
+				child->right->parent = retrace;
+
+			child->right = delNode->right;
+			child->right->parent = child;
 		}
 
-		if (delNode != nullptr) {
-			delNode->key = n_ptr->key;
+		child->left = delNode->left;
+		child->left->parent = child;
+		child->height = delNode->height; // so retracing compares against the height this spot had
+	}
+	else {
+		// at most one child, which takes its place
+		child = (delNode->left != nullptr) ? delNode->left : delNode->right;
+		retrace = delNode->parent;
+	}
+
+	Node *parent = delNode->parent;
+	if (child != nullptr)
+		child->parent = parent;
 
-			child = (n_ptr->left != nullptr) ? n_ptr->left : n_ptr->right;
+	if (parent == nullptr)
+		head_ = child;
+	else if (parent->left == delNode)
+		parent->left = child;
+	else
+		parent->right = child;
 
-			if (head_->key == key)
-				head_ = child;
-			else {
-				if (parent->left == n_ptr) 
-					parent->left = child;
-				else 
-					parent->right = child;
-		
-				balanceSubtree_(parent);
-			}
+	if (retrace != nullptr)
+		balanceSubtree_(retrace);
 
-			size_ = generateArr_(arr_);
-			return true;
+	deleteNode_(delNode);
+
+	--size_;
+	arrValid_ = false;
+	TREE_COUNT_(operations);
+	return true;
+}
+
+
+template<typename T, typename AllocT, typename AugmentT>
+int SearchTree<T, AllocT, AugmentT>::find_(const T &key) const {
+	const Node *n_ptr = head_;
+	int index = 0;
+
+	while (n_ptr != nullptr) {
+		if (n_ptr->key == key)
+			return index + count_(n_ptr->left);
+
+		if (key < n_ptr->key)
+			n_ptr = n_ptr->left;
+		else {
+			index += count_(n_ptr->left) + 1;
+			n_ptr = n_ptr->right;
 		}
 	}
-	return false;
+	return -1;
 }
 
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::select_(int i) const {
+	Node *n_ptr = head_;
 
-template<typename T>
-inline int SearchTree<T>::find_(const T &key, const Node *n_ptr) {
-	if (n_ptr->key == key)
-		return n_ptr->index;
+	while (n_ptr != nullptr) {
+		int left = count_(n_ptr->left);
+		if (i == left)
+			return n_ptr;
 
-	if (key < n_ptr->key) {
-		if (n_ptr->left != nullptr)
-			return find_(key, n_ptr->left);
+		if (i < left)
+			n_ptr = n_ptr->left;
+		else {
+			i -= left + 1;
+			n_ptr = n_ptr->right;
+		}
 	}
-	else {
-		if (n_ptr->right != nullptr)
-			return find_(key, n_ptr->right);
+	return nullptr;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::newNode_(const T &key, Node *parent) {
+	Node *n_ptr = NodeTraits::allocate(alloc_, 1);
+	NodeTraits::construct(alloc_, n_ptr, key, parent);
+	n_ptr->aggregate(AugmentT::of(n_ptr->key));
+	return n_ptr;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline void SearchTree<T, AllocT, AugmentT>::deleteNode_(Node *n_ptr) {
+	NodeTraits::destroy(alloc_, n_ptr);
+	NodeTraits::deallocate(alloc_, n_ptr, 1);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::destroy_(Node *n_ptr) {
+	// rotates left children up until there are none, so every node can be deleted on the way down the right
+	while (n_ptr != nullptr) {
+		if (n_ptr->left != nullptr) {
+			Node *left = n_ptr->left;
+			n_ptr->left = left->right;
+			left->right = n_ptr;
+			n_ptr = left;
+		}
+		else {
+			Node *right = n_ptr->right;
+			deleteNode_(n_ptr);
+			n_ptr = right;
+		}
 	}
-	return -1;
 }
 
-template<typename T>
-inline void SearchTree<T>::clear() {
-	for (int i = 0; i < size_; i++)
-		delete arr_[i];
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::collect_(Node *n_ptr, std::vector<Node *> &nodes) {
+	// same walk as destroy_
+	while (n_ptr != nullptr) {
+		if (n_ptr->left != nullptr) {
+			Node *left = n_ptr->left;
+			n_ptr->left = left->right;
+			left->right = n_ptr;
+			n_ptr = left;
+		}
+		else {
+			nodes.push_back(n_ptr);
+			n_ptr = n_ptr->right;
+		}
+	}
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline void SearchTree<T, AllocT, AugmentT>::deleteNodes_(std::vector<Node *> &garbage) {
+	for (Node *n_ptr : garbage)
+		deleteNode_(n_ptr);
+	garbage.clear();
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::copy_(const Node *n_ptr, Node *parent) {
+	if (n_ptr == nullptr)
+		return nullptr;
+
+	Node *n = newNode_(n_ptr->key, parent);
+	n->height = n_ptr->height;
+	n->count = n_ptr->count;
+	n->aggregate(n_ptr->aggregate());
+	n->left = copy_(n_ptr->left, n);
+	n->right = copy_(n_ptr->right, n);
+	return n;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::clear() {
+	// the allocator can drop every node at once if none need destroying
+	// unless another tree made with the same allocator takes its nodes from it too
+	bool released = false;
+	if constexpr (AllocatorReleases<NodeAllocT>::value && std::is_trivially_destructible<Node>::value) {
+		if (!alloc_.shared()) {
+			alloc_.release();
+			released = true;
+		}
+	}
+
+	if (!released)
+		destroy_(head_);
+
 	if (arr_ != nullptr)
 		delete[] arr_;
 	size_ = 0;
 	arr_ = nullptr;
+	arrValid_ = false;
 	head_ = nullptr;
 }
 
-template<typename T>
-inline int SearchTree<T>::find(const T key) const {
-	return (head_ == nullptr) ? -1 : find_(key, head_);
+template<typename T, typename AllocT, typename AugmentT>
+inline int SearchTree<T, AllocT, AugmentT>::find(const T key) const {
+	return find_(key);
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::first_(Node *n_ptr) {
+	if (n_ptr != nullptr) {
+		while (n_ptr->left != nullptr)
+			n_ptr = n_ptr->left;
+	}
+	return n_ptr;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::last_(Node *n_ptr) {
+	if (n_ptr != nullptr) {
+		while (n_ptr->right != nullptr)
+			n_ptr = n_ptr->right;
+	}
+	return n_ptr;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::successor_(Node *n_ptr) {
+	if (n_ptr->right != nullptr)
+		return first_(n_ptr->right);
+
+	while (n_ptr->parent != nullptr && n_ptr->parent->right == n_ptr)
+		n_ptr = n_ptr->parent;
+	return n_ptr->parent;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::predecessor_(Node *n_ptr) {
+	if (n_ptr->left != nullptr)
+		return last_(n_ptr->left);
+
+	while (n_ptr->parent != nullptr && n_ptr->parent->left == n_ptr)
+		n_ptr = n_ptr->parent;
+	return n_ptr->parent;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::lowerNode_(const T &key, bool strictly) const {
+	Node *n_ptr = head_, *found = nullptr;
+
+	while (n_ptr != nullptr) {
+		if (strictly ? (key < n_ptr->key) : !(n_ptr->key < key)) {
+			found = n_ptr;
+			n_ptr = n_ptr->left;
+		}
+		else
+			n_ptr = n_ptr->right;
+	}
+	return found;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+int SearchTree<T, AllocT, AugmentT>::countBelow_(const T &key, bool orEqual) const {
+	const Node *n_ptr = head_;
+	int count = 0;
+
+	while (n_ptr != nullptr) {
+		if (orEqual ? !(key < n_ptr->key) : (n_ptr->key < key)) {
+			count += count_(n_ptr->left) + 1;
+			n_ptr = n_ptr->right;
+		}
+		else
+			n_ptr = n_ptr->left;
+	}
+	return count;
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator SearchTree<T, AllocT, AugmentT>::start() const {
+	return Iterator(first_(head_), this);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator SearchTree<T, AllocT, AugmentT>::end() const {
+	return Iterator(nullptr, this);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator SearchTree<T, AllocT, AugmentT>::lowerBound(const T &key) const {
+	return Iterator(lowerNode_(key, false), this);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Iterator SearchTree<T, AllocT, AugmentT>::upperBound(const T &key) const {
+	return Iterator(lowerNode_(key, true), this);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline std::pair<typename SearchTree<T, AllocT, AugmentT>::Iterator, typename SearchTree<T, AllocT, AugmentT>::Iterator> SearchTree<T, AllocT, AugmentT>::equalRange(const T &key) const {
+	return std::make_pair(lowerBound(key), upperBound(key));
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+template<typename FuncT>
+inline void SearchTree<T, AllocT, AugmentT>::rangeVisit(const T &lo, const T &hi, FuncT fn) const {
+	for (Node *n_ptr = lowerNode_(lo, false); n_ptr != nullptr && !(hi < n_ptr->key); n_ptr = successor_(n_ptr))
+		fn(static_cast<const T &>(n_ptr->key));
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline int SearchTree<T, AllocT, AugmentT>::countInRange(const T &lo, const T &hi) const {
+	return (hi < lo) ? 0 : countBelow_(hi, true) - countBelow_(lo, false);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::AggregateT SearchTree<T, AllocT, AugmentT>::aggregate() const {
+	return aggregate_(head_);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::AggregateT SearchTree<T, AllocT, AugmentT>::aggregate(const T &lo, const T &hi) const {
+	// highest node in [lo, hi], every other node in range is below it
+	const Node *top = head_;
+	while (top != nullptr && (top->key < lo || hi < top->key))
+		top = (top->key < lo) ? top->right : top->left;
+
+	if (top == nullptr)
+		return AugmentT::identity();
+
+	// down the left side, every node >= lo brings its right subtree along, each one before everything found so far
+	AggregateT left = AugmentT::identity();
+	for (const Node *n_ptr = top->left; n_ptr != nullptr; ) {
+		if (n_ptr->key < lo)
+			n_ptr = n_ptr->right;
+		else {
+			left = AugmentT::combine(AugmentT::combine(AugmentT::of(n_ptr->key), aggregate_(n_ptr->right)), left);
+			n_ptr = n_ptr->left;
+		}
+	}
+
+	// and mirrored down the right side
+	AggregateT right = AugmentT::identity();
+	for (const Node *n_ptr = top->right; n_ptr != nullptr; ) {
+		if (hi < n_ptr->key)
+			n_ptr = n_ptr->left;
+		else {
+			right = AugmentT::combine(right, AugmentT::combine(aggregate_(n_ptr->left), AugmentT::of(n_ptr->key)));
+			n_ptr = n_ptr->right;
+		}
+	}
+
+	return AugmentT::combine(AugmentT::combine(left, AugmentT::of(top->key)), right);
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+FrozenTree<T> SearchTree<T, AllocT, AugmentT>::freeze() const {
+	std::vector<T> keys;
+	keys.reserve(size_);
+
+	std::vector<const Node *> path;
+	const Node *n_ptr = head_;
+	while (n_ptr != nullptr || !path.empty()) {
+		while (n_ptr != nullptr) {
+			path.push_back(n_ptr);
+			n_ptr = n_ptr->left;
+		}
+		n_ptr = path.back();
+		path.pop_back();
+		keys.push_back(n_ptr->key);
+		n_ptr = n_ptr->right;
+	}
+
+	return FrozenTree<T>(keys.data(), (unsigned)keys.size());
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::load_(std::vector<T> &arr) {
+	if (!std::is_sorted(arr.begin(), arr.end()))
+		sort_(arr.data(), arr.data() + arr.size(), parallelDepth_());
+	arr.erase(std::unique(arr.begin(), arr.end()), arr.end());
+
+	std::vector<Node *> nodes(arr.size());
+	for (std::size_t i = 0; i < arr.size(); i++)
+		nodes[i] = newNode_(arr[i]);
+
+	head_ = build_(nodes.data(), (int)nodes.size(), parallelDepth_());
+	size_ = (int)nodes.size();
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+int SearchTree<T, AllocT, AugmentT>::parallelDepth_() {
+	int depth = 0;
+	for (unsigned threads = std::thread::hardware_concurrency(); threads > 1; threads = (threads + 1) / 2)
+		depth++;
+	return depth;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+template<typename FuncT>
+auto SearchTree<T, AllocT, AugmentT>::async_(FuncT fn) -> std::future<decltype(fn())> {
+	try {
+		return std::async(std::launch::async, fn);
+	}
+	catch (const std::system_error &) {
+		return std::async(std::launch::deferred, fn);
+	}
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::sort_(T *begin, T *end, int depth) {
+	if (depth <= 0 || end - begin <= TREE_PARALLEL_THRESHOLD) {
+		std::sort(begin, end);
+		return;
+	}
+
+	T *mid = begin + (end - begin) / 2;
+	std::future<void> left = async_([=]() { sort_(begin, mid, depth - 1); });
+	sort_(mid, end, depth - 1);
+	left.get();
+	std::inplace_merge(begin, mid, end);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::build_(Node *const *nodes, int size, int depth) {
+	if (size == 0)
+		return nullptr;
+
+	int mid = size / 2;
+	Node *left, *right;
+
+	if (depth > 0 && size > TREE_PARALLEL_THRESHOLD) {
+		std::future<Node *> l = async_([=]() { return build_(nodes, mid, depth - 1); });
+		right = build_(nodes + mid + 1, size - mid - 1, depth - 1);
+		left = l.get();
+	}
+	else {
+		left = build_(nodes, mid, depth);
+		right = build_(nodes + mid + 1, size - mid - 1, depth);
+	}
+
+	return link_(left, nodes[mid], right);
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::link_(Node *l, Node *n, Node *r) {
+	n->left = l;
+	n->right = r;
+	n->parent = nullptr;
+	if (l != nullptr)
+		l->parent = n;
+	if (r != nullptr)
+		r->parent = n;
+	update_(n);
+	return n;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::joinRight_(Node *l, Node *n, Node *r) {
+	Node *ll = l->left, *lr = l->right;
+
+	if (height_(lr) <= height_(r) + 1) {
+		Node *joined = link_(lr, n, r);
+		if (height_(joined) <= height_(ll) + 1)
+			return link_(ll, l, joined);
+		return rotateLeft_(link_(ll, l, rotateRight_(joined)));
+	}
+
+	Node *joined = joinRight_(lr, n, r);
+	Node *root = link_(ll, l, joined);
+	if (height_(joined) <= height_(ll) + 1)
+		return root;
+	return rotateLeft_(root);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::joinLeft_(Node *l, Node *n, Node *r) {
+	Node *rl = r->left, *rr = r->right;
+
+	if (height_(rl) <= height_(l) + 1) {
+		Node *joined = link_(l, n, rl);
+		if (height_(joined) <= height_(rr) + 1)
+			return link_(joined, r, rr);
+		return rotateRight_(link_(rotateLeft_(joined), r, rr));
+	}
+
+	Node *joined = joinLeft_(l, n, rl);
+	Node *root = link_(joined, r, rr);
+	if (height_(joined) <= height_(rr) + 1)
+		return root;
+	return rotateRight_(root);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::join_(Node *l, Node *n, Node *r) {
+	if (height_(l) > height_(r) + 1)
+		return joinRight_(l, n, r);
+	if (height_(r) > height_(l) + 1)
+		return joinLeft_(l, n, r);
+	return link_(l, n, r);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::splitLast_(Node *n_ptr, Node *&last) {
+	if (n_ptr->right == nullptr) {
+		last = n_ptr;
+		if (n_ptr->left != nullptr)
+			n_ptr->left->parent = nullptr;
+		return n_ptr->left;
+	}
+	Node *l = n_ptr->left;
+	Node *r = splitLast_(n_ptr->right, last);
+	return join_(l, n_ptr, r);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+inline typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::join2_(Node *l, Node *r) {
+	if (l == nullptr) {
+		if (r != nullptr)
+			r->parent = nullptr;
+		return r;
+	}
+	Node *last;
+	l = splitLast_(l, last);
+	return join_(l, last, r);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::split_(Node *n_ptr, const T &key, Node *&l, Node *&r) {
+	if (n_ptr == nullptr) {
+		l = r = nullptr;
+		return nullptr;
+	}
+
+	Node *left = n_ptr->left, *right = n_ptr->right;
+	Node *found;
+
+	if (n_ptr->key == key) {
+		if (left != nullptr)
+			left->parent = nullptr;
+		if (right != nullptr)
+			right->parent = nullptr;
+		l = left;
+		r = right;
+		link_(nullptr, n_ptr, nullptr);
+		return n_ptr;
+	}
+
+	if (key < n_ptr->key) {
+		Node *mid;
+		found = split_(left, key, l, mid);
+		r = join_(mid, n_ptr, right);
+	}
+	else {
+		Node *mid;
+		found = split_(right, key, mid, r);
+		l = join_(left, n_ptr, mid);
+	}
+	return found;
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::unite_(Node *a, Node *b, std::vector<Node *> &garbage, int depth) {
+	if (a == nullptr)
+		return b;
+	if (b == nullptr)
+		return a;
+
+	Node *bl, *br;
+	Node *dup = split_(b, a->key, bl, br);
+	if (dup != nullptr)
+		garbage.push_back(dup);
+
+	Node *al = a->left, *ar = a->right;
+	Node *l, *r;
+
+	if (depth > 0 && count_(a) + count_(bl) + count_(br) > TREE_PARALLEL_THRESHOLD) {
+		std::vector<Node *> leftGarbage;
+		std::future<Node *> left = async_([=, &leftGarbage]() { return unite_(al, bl, leftGarbage, depth - 1); });
+		r = unite_(ar, br, garbage, depth - 1);
+		l = left.get();
+		garbage.insert(garbage.end(), leftGarbage.begin(), leftGarbage.end());
+	}
+	else {
+		l = unite_(al, bl, garbage, depth);
+		r = unite_(ar, br, garbage, depth);
+	}
+
+	return join_(l, a, r);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::intersect_(Node *a, Node *b, std::vector<Node *> &garbage, int depth) {
+	if (a == nullptr || b == nullptr) {
+		collect_(a, garbage);
+		collect_(b, garbage);
+		return nullptr;
+	}
+
+	Node *bl, *br;
+	Node *dup = split_(b, a->key, bl, br);
+
+	Node *al = a->left, *ar = a->right;
+	Node *l, *r;
+
+	if (depth > 0 && count_(a) + count_(bl) + count_(br) > TREE_PARALLEL_THRESHOLD) {
+		std::vector<Node *> leftGarbage;
+		std::future<Node *> left = async_([=, &leftGarbage]() { return intersect_(al, bl, leftGarbage, depth - 1); });
+		r = intersect_(ar, br, garbage, depth - 1);
+		l = left.get();
+		garbage.insert(garbage.end(), leftGarbage.begin(), leftGarbage.end());
+	}
+	else {
+		l = intersect_(al, bl, garbage, depth);
+		r = intersect_(ar, br, garbage, depth);
+	}
+
+	if (dup != nullptr) {
+		garbage.push_back(dup);
+		return join_(l, a, r);
+	}
+	garbage.push_back(a);
+	return join2_(l, r);
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+typename SearchTree<T, AllocT, AugmentT>::Node * SearchTree<T, AllocT, AugmentT>::subtract_(Node *a, Node *b, std::vector<Node *> &garbage, int depth) {
+	if (a == nullptr || b == nullptr) {
+		collect_(b, garbage);
+		if (a != nullptr)
+			a->parent = nullptr;
+		return a;
+	}
+
+	Node *al, *ar;
+	Node *dup = split_(a, b->key, al, ar);
+	if (dup != nullptr)
+		garbage.push_back(dup);
+
+	Node *bl = b->left, *br = b->right;
+	garbage.push_back(b);
+	Node *l, *r;
+
+	if (depth > 0 && count_(al) + count_(ar) + count_(bl) + count_(br) > TREE_PARALLEL_THRESHOLD) {
+		std::vector<Node *> leftGarbage;
+		std::future<Node *> left = async_([=, &leftGarbage]() { return subtract_(al, bl, leftGarbage, depth - 1); });
+		r = subtract_(ar, br, garbage, depth - 1);
+		l = left.get();
+		garbage.insert(garbage.end(), leftGarbage.begin(), leftGarbage.end());
+	}
+	else {
+		l = subtract_(al, bl, garbage, depth);
+		r = subtract_(ar, br, garbage, depth);
+	}
+
+	return join2_(l, r);
+}
+
+
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::unite(const SearchTree &tree) {
+	std::vector<Node *> garbage;
+	head_ = unite_(head_, copy_(tree.head_, nullptr), garbage, parallelDepth_());
+	deleteNodes_(garbage);
+	size_ = count_(head_);
+	arrValid_ = false;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::intersect(const SearchTree &tree) {
+	std::vector<Node *> garbage;
+	head_ = intersect_(head_, copy_(tree.head_, nullptr), garbage, parallelDepth_());
+	deleteNodes_(garbage);
+	size_ = count_(head_);
+	arrValid_ = false;
+}
+
+template<typename T, typename AllocT, typename AugmentT>
+void SearchTree<T, AllocT, AugmentT>::subtract(const SearchTree &tree) {
+	std::vector<Node *> garbage;
+	head_ = subtract_(head_, copy_(tree.head_, nullptr), garbage, parallelDepth_());
+	deleteNodes_(garbage);
+	size_ = count_(head_);
+	arrValid_ = false;
 }
 
 #ifdef TREE_PRINTING
-template<typename T>
-inline void SearchTree<T>::print_(Node *root, int space) {
+template<typename T, typename AllocT, typename AugmentT>
+inline void SearchTree<T, AllocT, AugmentT>::print_(Node *root, int space) {
 	if (root != nullptr) {
 		// Increase distance between levels  
 		space += LEAF_SPACING;
@@ -405,19 +1295,19 @@ inline void SearchTree<T>::print_(Node *root, int space) {
 }
 #endif
 
-template<typename T>
-inline SearchTree<T>::SearchTree(const T arr[], const unsigned size)
-	: size_(0), head_(nullptr), arr_(nullptr), arrValid_(false) {
-	for (unsigned i = 0; i < size; i++)
-		insert(arr[i]);
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT>::SearchTree(const T arr[], const unsigned size, const AllocT &alloc)
+	: alloc_(alloc), head_(nullptr), arr_(nullptr), size_(0), arrValid_(false) {
+	std::vector<T> copy(arr, arr + size);
+	load_(copy);
 }
 
-template<typename T>
-inline SearchTree<T>::~SearchTree() {
+template<typename T, typename AllocT, typename AugmentT>
+inline SearchTree<T, AllocT, AugmentT>::~SearchTree() {
 	clear(); 
 }
 
-template<typename T>
-inline int SearchTree<T>::size() const {
+template<typename T, typename AllocT, typename AugmentT>
+inline int SearchTree<T, AllocT, AugmentT>::size() const {
 	return size_;
 }
\ No newline at end of file
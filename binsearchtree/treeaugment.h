@@ -0,0 +1,78 @@
+#pragma once
+
+// Search Tree Augmentations
+// Written by ItsNorin      https://github.com/ItsNorin/
+
+// an augmentation keeps a value for every subtree of a SearchTree, combined from its children on every change,
+// so it can be asked for over any range of keys in O(log n) instead of scanning the range
+// an augmentation is a monoid over keys, it must provide:
+//     Value                                    type of the value kept in each node
+//     static Value identity()                  value of an empty subtree
+//     static Value of(const T &key)            value of a single key
+//     static Value combine(a, b)               value of a followed by b, must be associative
+
+#include <limits>
+#include <type_traits>
+
+// default augmentation, keeps nothing and takes no space in nodes
+template<typename T>
+struct TreeNoAugment {
+	struct Value {};
+	static Value identity() { return Value(); }
+	static Value of(const T &) { return Value(); }
+	static Value combine(const Value &, const Value &) { return Value(); }
+};
+
+// sum of keys
+template<typename T>
+struct TreeSum {
+	typedef T Value;
+	static Value identity() { return T(); }
+	static Value of(const T &key) { return key; }
+	static Value combine(const Value &a, const Value &b) { return a + b; }
+};
+
+// smallest key, identity is the largest value T can hold
+template<typename T>
+struct TreeMin {
+	typedef T Value;
+	static Value identity() { return std::numeric_limits<T>::max(); }
+	static Value of(const T &key) { return key; }
+	static Value combine(const Value &a, const Value &b) { return (b < a) ? b : a; }
+};
+
+// largest key, identity is the smallest value T can hold
+template<typename T>
+struct TreeMax {
+	typedef T Value;
+	static Value identity() { return std::numeric_limits<T>::lowest(); }
+	static Value of(const T &key) { return key; }
+	static Value combine(const Value &a, const Value &b) { return (a < b) ? b : a; }
+};
+
+// number of keys
+template<typename T>
+struct TreeCount {
+	typedef int Value;
+	static Value identity() { return 0; }
+	static Value of(const T &) { return 1; }
+	static Value combine(const Value &a, const Value &b) { return a + b; }
+};
+
+
+// storage for a node's aggregate, a base class so an empty Value takes no space
+template<typename ValueT, bool Empty = std::is_empty<ValueT>::value>
+class TreeAggregateSlot {
+public:
+	ValueT agg; // value of the node's whole subtree
+
+	const ValueT & aggregate() const { return agg; }
+	void aggregate(const ValueT &value) { agg = value; }
+};
+
+template<typename ValueT>
+class TreeAggregateSlot<ValueT, true> {
+public:
+	ValueT aggregate() const { return ValueT(); }
+	void aggregate(const ValueT &) {}
+};
@@ -0,0 +1,273 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include "../hashmap/chainedhashmap.h"
+#include "../linked list/linkedlist.h"
+
+// A bounded cache, a hashmap indexing into a list of its entries
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// the hashmap finds a key's node in the list, and the list keeps entries in eviction order,
+// so get, put and evicting are all constant time
+//
+// LRU keeps the most recently used entry at the front, and evicts from the back
+// Clock sweeps a hand around the list, every hit adds a reference to an entry, up to CACHE_CLOCK_MAX_REFS,
+// and the hand takes one away from each entry it passes, evicting the first it finds with none left
+// entries hit often survive more sweeps, an approximation of LFU that never moves nodes around on a hit
+
+#define CACHE_CLOCK_MAX_REFS 3 // most references a Clock entry can build up, higher remembers frequency for longer
+
+enum class CachePolicy {
+	LRU,
+	Clock
+};
+
+
+// weighs every entry as 1, making a cache's capacity a number of entries
+template<typename KeyT, typename DataT>
+struct CacheUnitWeight {
+	std::size_t operator()(const KeyT &, const DataT &) const { return 1; }
+};
+
+
+// WeightT is a function object returning an entry's weight from its key and data, such as its size in bytes
+// the total weight of all entries is kept below capacity
+template<typename KeyT, typename DataT, typename WeightT = CacheUnitWeight<KeyT, DataT>,
+	typename HashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>>
+class Cache {
+protected:
+	// element in cache, with its place in the eviction order
+	struct Item {
+		KeyT key;
+		DataT data;
+		std::size_t weight;
+		unsigned refs;
+	};
+
+	typedef typename List<Item>::Iterator ItemIt;
+
+public:
+	// creates a cache holding at most capacity weight of entries
+	Cache(std::size_t capacity, CachePolicy policy = CachePolicy::LRU, const WeightT &weigher = WeightT(),
+		const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	Cache(const Cache &cache) = delete;
+	Cache & operator=(const Cache &cache) = delete;
+
+	// search for the data associated with the given key, counted as a hit or miss and marking the entry used
+	// returns pointer to key's associated data if found, if not found, returns nullptr
+	// pointer is valid until the entry is evicted or removed
+	DataT * get(const KeyT &key);
+
+	// search without counting it or marking the entry used
+	const DataT * peek(const KeyT &key) const;
+
+	// inserts an entry, or replaces the data of an existing one and marks it used
+	// evicts entries until the cache fits in its capacity again
+	// false if the entry weighs more than the whole capacity and so was not stored
+	bool put(const KeyT &key, const DataT &data);
+
+	// remove a key from cache, not counted as an eviction
+	// true if removed, false if not found
+	bool remove(const KeyT &key);
+
+	// removes every entry, counters are kept
+	void clear();
+
+	// changes the capacity, evicting entries until the cache fits in it
+	void capacity(std::size_t capacity);
+	std::size_t capacity() const;
+
+	// number of entries cache is storing
+	unsigned entries() const;
+
+	// total weight of every entry
+	std::size_t weight() const;
+
+	// number of gets that found, and didnt find their key
+	std::size_t hits() const;
+	std::size_t misses() const;
+
+	// number of entries evicted to make room
+	std::size_t evictions() const;
+
+	// sets hits, misses and evictions to 0
+	void resetCounters();
+
+protected:
+	CachePolicy policy_;
+	std::size_t capacity_, weight_;
+	WeightT weigher_;
+
+	std::size_t hits_, misses_, evictions_;
+
+	// entries in eviction order
+	List<Item> items_;
+
+	// node of every key in items_
+	ChainedHashMap<KeyT, ItemIt, HashT, KeyEqualT> index_;
+
+	// Clock's hand, the next entry it looks at, items_.end() when it has to wrap around
+	ItemIt hand_;
+
+protected:
+	// marks an entry as used
+	void touch_(ItemIt it);
+
+	// removes an entry from both list and index
+	void erase_(ItemIt it);
+
+	// evicts entries until weight_ is at most capacity_
+	void shrink_();
+};
+
+
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::Cache(std::size_t capacity, CachePolicy policy, const WeightT &weigher,
+	const HashT &hasher, const KeyEqualT &keyEqual)
+	: policy_(policy), capacity_(capacity), weight_(0), weigher_(weigher),
+	  hits_(0), misses_(0), evictions_(0),
+	  index_(HASHMAP_BASIC_SIZE, hasher, keyEqual), hand_(items_.end())
+{}
+
+
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline void Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::touch_(ItemIt it) {
+	if (policy_ == CachePolicy::LRU)
+		items_.moveBefore(items_.start(), it);
+	else if ((*it).refs < CACHE_CLOCK_MAX_REFS)
+		(*it).refs++;
+}
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline void Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::erase_(ItemIt it) {
+	weight_ -= (*it).weight;
+	index_.remove((*it).key);
+	if (it == hand_)
+		hand_ = items_.erase(it);
+	else
+		items_.erase(it);
+}
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+void Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::shrink_() {
+	while (weight_ > capacity_ && items_.size() > 0) {
+		if (policy_ == CachePolicy::LRU) {
+			erase_(items_.end().prev());
+		}
+		else {
+			if (hand_ == items_.end())
+				hand_ = items_.start();
+
+			if ((*hand_).refs > 0) {
+				(*hand_).refs--;
+				++hand_;
+				continue;
+			}
+			erase_(hand_);
+		}
+		evictions_++;
+	}
+}
+
+
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline DataT * Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::get(const KeyT &key) {
+	ItemIt *it = index_.find(key);
+	if (it == nullptr) {
+		misses_++;
+		return nullptr;
+	}
+
+	hits_++;
+	touch_(*it);
+	return &(**it).data;
+}
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline const DataT * Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::peek(const KeyT &key) const {
+	ItemIt *it = index_.find(key);
+	return (it != nullptr) ? &(**it).data : nullptr;
+}
+
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+bool Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::put(const KeyT &key, const DataT &data) {
+	std::size_t weight = weigher_(key, data);
+	ItemIt *found = index_.find(key);
+
+	if (weight > capacity_) {
+		if (found != nullptr)
+			erase_(*found);
+		return false;
+	}
+
+	if (found != nullptr) {
+		ItemIt it = *found;
+		weight_ += weight - (*it).weight;
+		(*it).data = data;
+		(*it).weight = weight;
+		touch_(it);
+	}
+	else {
+		// LRU puts new entries at the front, Clock puts them right behind its hand, the last place it will look
+		ItemIt it = items_.insertBefore((policy_ == CachePolicy::LRU) ? items_.start() : hand_, Item{ key, data, weight, 0 });
+		index_.insert(key, it);
+		weight_ += weight;
+	}
+
+	shrink_();
+	return true;
+}
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline bool Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::remove(const KeyT &key) {
+	ItemIt *it = index_.find(key);
+	if (it == nullptr)
+		return false;
+	erase_(*it);
+	return true;
+}
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline void Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::clear() {
+	for (ItemIt it = items_.start(); it != items_.end(); ++it)
+		index_.remove((*it).key);
+	items_.clear();
+	hand_ = items_.end();
+	weight_ = 0;
+}
+
+
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline void Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::capacity(std::size_t capacity) {
+	capacity_ = capacity;
+	shrink_();
+}
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline std::size_t Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::capacity() const { return capacity_; }
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline unsigned Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::entries() const { return items_.size(); }
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline std::size_t Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::weight() const { return weight_; }
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline std::size_t Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::hits() const { return hits_; }
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline std::size_t Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::misses() const { return misses_; }
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline std::size_t Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::evictions() const { return evictions_; }
+
+template<typename KeyT, typename DataT, typename WeightT, typename HashT, typename KeyEqualT>
+inline void Cache<KeyT, DataT, WeightT, HashT, KeyEqualT>::resetCounters() {
+	hits_ = misses_ = evictions_ = 0;
+}
@@ -0,0 +1,43 @@
+#include "frozengraph.h"
+
+FrozenGraph::FrozenGraph()
+	: offsets_(1, 0)
+{}
+
+FrozenGraph::FrozenGraph(std::vector<PointT> &&points, std::vector<unsigned> &&offsets, std::vector<unsigned> &&targets, std::vector<int> &&weights)
+	: points_(std::move(points)), offsets_(std::move(offsets)), targets_(std::move(targets)), weights_(std::move(weights)),
+	  ids_(idMap_(points_))
+{}
+
+FrozenHashMap<PointT, unsigned> FrozenGraph::idMap_(const std::vector<PointT> &points) {
+	// points are already unique, so the map is built straight from them without hashing them into a ChainedHashMap
+	std::vector<FrozenHashMap<PointT, unsigned>::Entry> entries;
+	entries.reserve(points.size());
+	for (unsigned id = 0; id < points.size(); id++)
+		entries.emplace_back(points[id], id);
+	return FrozenHashMap<PointT, unsigned>(entries);
+}
+
+int FrozenGraph::idOf(const PointT &point) const {
+	const unsigned *id = ids_.find(point);
+	return (id == nullptr) ? -1 : (int)*id;
+}
+
+std::vector<PointT> FrozenGraph::pathOf_(unsigned start, unsigned goal) const {
+	std::vector<unsigned> ids = Pathfinder::local().path(start, goal);
+	std::vector<PointT> path;
+	path.reserve(ids.size());
+	for (unsigned id : ids)
+		path.push_back(points_[id]);
+	return path;
+}
+
+std::vector<PointT> FrozenGraph::pathfindDijkstra(const PointT &start, const PointT &goal, PathfindQueue queue) const {
+	int startId = idOf(start), goalId = idOf(goal);
+	if (startId < 0 || goalId < 0)
+		return std::vector<PointT>();
+
+	if (!Pathfinder::local().dijkstra(*this, (unsigned)startId, (unsigned)goalId, queue))
+		return std::vector<PointT>();
+	return pathOf_((unsigned)startId, (unsigned)goalId);
+}
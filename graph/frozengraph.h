@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include "../hashmap/frozenhashmap.h"
+#include "graph.h"
+
+// Frozen Graph
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// an immutable snapshot of a Graph in compressed sparse row form, made by Graph::freeze()
+// every point gets a dense id, and the links of node id are entries offsets[id] through offsets[id + 1] - 1
+// of two flat arrays of targets and weights, so following links reads memory in order instead of hashing points
+// and chasing pointers between separately allocated link vectors
+// points are only hashed to turn them into ids, through a FrozenHashMap, once per query
+
+class FrozenGraph {
+	friend class Pathfinder;
+
+protected:
+	std::vector<PointT> points_;     // point of each id
+	std::vector<unsigned> offsets_;  // first link of each id, with one extra entry holding the total number of links
+	std::vector<unsigned> targets_;  // id each link goes to
+	std::vector<int> weights_;       // weight of each link
+
+	// id of each point
+	FrozenHashMap<PointT, unsigned> ids_;
+
+protected:
+	// builds the map from points to ids
+	static FrozenHashMap<PointT, unsigned> idMap_(const std::vector<PointT> &points);
+
+	// for Pathfinder
+	unsigned nodeCount_() const { return (unsigned)points_.size(); }
+	template<typename FuncT>
+	void forEachLink_(unsigned id, FuncT fn) const;
+	const PointT & pointOf_(unsigned id) const { return points_[id]; }
+
+	// points from start to goal of the path the last search found
+	std::vector<PointT> pathOf_(unsigned start, unsigned goal) const;
+
+public:
+	// creates an empty graph
+	FrozenGraph();
+
+	// creates a graph from arrays already in compressed sparse row form, see above
+	// offsets must have points.size() + 1 entries, and every target must be an id below points.size()
+	FrozenGraph(std::vector<PointT> &&points, std::vector<unsigned> &&offsets, std::vector<unsigned> &&targets, std::vector<int> &&weights);
+
+	// number of points in graph
+	unsigned size() const { return nodeCount_(); }
+
+	// number of links in graph, each link between two points counts once in each direction
+	unsigned linkCount() const { return (unsigned)targets_.size(); }
+
+	// true if point is in graph
+	bool contains(const PointT &point) const { return ids_.find(point) != nullptr; }
+
+	// id of a point, -1 if it isn't in graph
+	int idOf(const PointT &point) const;
+
+	// point with a given id
+	const PointT & pointOf(unsigned id) const { return points_[id]; }
+
+	// number of links out of a node
+	unsigned degree(unsigned id) const { return offsets_[id + 1] - offsets_[id]; }
+
+	// ids and weights of the links out of a node, degree(id) of each
+	const unsigned * targetsOf(unsigned id) const { return targets_.data() + offsets_[id]; }
+	const int * weightsOf(unsigned id) const { return weights_.data() + offsets_[id]; }
+
+public:
+	// same as Graph::pathfindDijkstra
+	std::vector<PointT> pathfindDijkstra(const PointT &start, const PointT &goal, PathfindQueue queue = PathfindQueue::BinaryHeap) const;
+
+	// same as Graph::pathfindAStar
+	template<typename HeuristicT = EuclideanHeuristic>
+	std::vector<PointT> pathfindAStar(const PointT &start, const PointT &goal, HeuristicT heuristic = HeuristicT(), double weight = 1) const;
+
+	// number of nodes the last pathfind on this thread explored, on any graph
+	static unsigned lastExpanded() { return Pathfinder::local().expanded(); }
+};
+
+
+
+template<typename FuncT>
+inline void FrozenGraph::forEachLink_(unsigned id, FuncT fn) const {
+	for (unsigned i = offsets_[id], end = offsets_[id + 1]; i < end; i++)
+		fn(targets_[i], weights_[i]);
+}
+
+template<typename HeuristicT>
+std::vector<PointT> FrozenGraph::pathfindAStar(const PointT &start, const PointT &goal, HeuristicT heuristic, double weight) const {
+	int startId = idOf(start), goalId = idOf(goal);
+	if (startId < 0 || goalId < 0)
+		return std::vector<PointT>();
+
+	if (!Pathfinder::local().aStar(*this, (unsigned)startId, (unsigned)goalId, heuristic, weight))
+		return std::vector<PointT>();
+	return pathOf_((unsigned)startId, (unsigned)goalId);
+}
@@ -1,11 +1,14 @@
 #include "graph.h"
+#include "frozengraph.h"
 #include <algorithm>
+#include <climits>
 
 Graph::Node::Node() 
+	: id_(0)
 {}
 
 Graph::Node::Node(const PointT point)
-	: point_(point)
+	: point_(point), id_(0)
 {}
 
 PointT Graph::Node::point() const {
@@ -55,26 +58,52 @@ void Graph::Node::unlink(Node *n) {
  * GRAPH METHODS
 */
 
+Graph::Node * Graph::nodeOf_(const PointT &point) {
+	auto inserted = map_.insert(std::make_pair(point, Graph::Node(point)));
+	Node *n = &(*inserted.first).second;
+
+	// nodes in an unordered_map never move, so pointers to them stay valid as it grows
+	if (inserted.second) {
+		n->id_ = (unsigned)nodes_.size();
+		nodes_.push_back(n);
+	}
+	return n;
+}
+
 bool Graph::insert(const PointT &point) {
-	return map_.insert(std::make_pair(point, Graph::Node(point))).second;
+	unsigned count = nodeCount_();
+	nodeOf_(point);
+	return nodeCount_() != count;
 }
 
 bool Graph::remove(const PointT &point) {
-	Node *toDel = &map_[point];
+	auto found = map_.find(point);
+	if (found == map_.end())
+		return false;
+
+	Node *toDel = &(*found).second;
 	// remove all links to node
 	while (toDel->links_.size() > 0) 
 		toDel->links_[0].first->unlink(toDel);
-		
-	map_.erase(toDel->point_);
-	return false; 
+
+	// last node takes over the removed node's id, so ids stay dense
+	nodes_[toDel->id_] = nodes_.back();
+	nodes_[toDel->id_]->id_ = toDel->id_;
+	nodes_.pop_back();
+
+	map_.erase(found);
+	return true; 
 }
 
 void Graph::link(const PointT &point, const PointT &neighbor, const int weight) {
-	map_[point].link(&map_[neighbor], weight);
+	Node *n = nodeOf_(point);
+	n->link(nodeOf_(neighbor), weight);
 }
 
 void Graph::unlink(const PointT &point, const PointT &neighbor) {
-	map_[point].unlink(&map_[neighbor]);
+	auto found = map_.find(point), foundNeighbor = map_.find(neighbor);
+	if (found != map_.end() && foundNeighbor != map_.end())
+		(*found).second.unlink(&(*foundNeighbor).second);
 }
 
 bool Graph::contains(const PointT & point) const {
@@ -89,66 +118,77 @@ const std::vector<std::pair<Graph::Node*, int>> Graph::linksOf(const PointT &p)
 }
 
 
-// TODO: 
-// test pathfinding to ensure it doesnt break when:
-// - there is no valid path from start to goal
-// - start and goal are the same
-// - start and/or goal aren't in graph
-
-std::vector<PointT> Graph::pathfindDijkstra(const PointT &start, const PointT &goal) const {
-	if (contains(start) && contains(goal)) {
-		std::unordered_map<PointT, Node> unexploredNodes = map_;
-		std::unordered_map<PointT, int> distanceFromStart; // given any point, what is its distance from start
-		std::unordered_map<PointT, const PointT*> pathParents; // previous point for each point in the path
-
-		for (auto it = unexploredNodes.begin(); it != unexploredNodes.end(); it++) {
-			distanceFromStart.insert({ (*it).first, INT_MAX }); // make each starting distance as large as possible
-			pathParents.insert({ (*it).first, nullptr }); // insert an invalid parent point for each point in map
-		}
-
-		distanceFromStart[start] = 0; // distance from start -> start is 0
-
-		while (unexploredNodes.size() > 0) {
-			// get point with least distance from start
-			const PointT *current = &(*unexploredNodes.begin()).first;
-			for (auto it = unexploredNodes.begin(); it != unexploredNodes.end(); it++) {
-				if (distanceFromStart[(*it).first] < distanceFromStart[*current]) 
-					current = &(*it).first;
-			}
+std::vector<PointT> Graph::pathfindDijkstra(const PointT &start, const PointT &goal, PathfindQueue queue) const {
+	auto startNode = map_.find(start), goalNode = map_.find(goal);
+	if (startNode == map_.end() || goalNode == map_.end())
+		return std::vector<PointT>();
 
-			// if path was found, put path into a vector to return
-			if (*current == goal) {
-				std::vector<PointT> path;
-				path.push_back(goal);
+	unsigned startId = (*startNode).second.id_, goalId = (*goalNode).second.id_;
+	if (!Pathfinder::local().dijkstra(*this, startId, goalId, queue))
+		return std::vector<PointT>();
+	return pathOf_(startId, goalId);
+}
 
-				// start from goal, then trace its parents back to current node
-				while (path.back() != start)
-					path.push_back(*pathParents[path.back()]);
+unsigned Graph::lastExpanded() {
+	return Pathfinder::local().expanded();
+}
 
-				// reverse path to go from start to goal
-				std::reverse(path.begin(), path.end());
+std::vector<PointT> Graph::pathOf_(unsigned start, unsigned goal) const {
+	std::vector<unsigned> ids = Pathfinder::local().path(start, goal);
+	std::vector<PointT> path;
+	path.reserve(ids.size());
+	for (unsigned id : ids)
+		path.push_back(nodes_[id]->point_);
+	return path;
+}
 
-				return path;
-			}
-			else {
-				const std::vector<std::pair<Node *, int>> &links = linksOf(*current);
-
-				// for each neighbor of the current node,
-				for (auto it = links.begin(); it < links.end(); it++) {
-					// update their distanceFromStart if it is less than what it is currently
-					PointT neighborPoint = (*it).first->point_;
-					int distance = distanceFromStart[*current] + (*it).second;
-
-					if (distance < distanceFromStart[neighborPoint]) {
-						distanceFromStart[neighborPoint] = distance;
-						pathParents[neighborPoint] = &(*map_.find(*current)).first;
-					}
+FrozenGraph Graph::freeze() const {
+	unsigned n = nodeCount_();
+
+	// nodes are given new ids in breadth first order, so nodes linked to each other end up near each other in memory
+	std::vector<unsigned> newId(n, UINT_MAX);
+	std::vector<unsigned> order;
+	order.reserve(n);
+
+	for (unsigned root = 0; root < n; root++) {
+		if (newId[root] != UINT_MAX)
+			continue;
+
+		newId[root] = (unsigned)order.size();
+		order.push_back(root);
+		for (std::size_t next = order.size() - 1; next < order.size(); next++) {
+			for (const std::pair<Node *, int> &link : nodes_[order[next]]->links_) {
+				unsigned neighbor = link.first->id_;
+				if (newId[neighbor] == UINT_MAX) {
+					newId[neighbor] = (unsigned)order.size();
+					order.push_back(neighbor);
 				}
-				// remove explored node
-				unexploredNodes.erase(*current);
 			}
 		}
 	}
 
-	return std::vector<PointT>();
+	std::vector<PointT> points(n);
+	std::vector<unsigned> offsets(n + 1);
+	std::vector<unsigned> targets;
+	std::vector<int> weights;
+
+	std::size_t linkCount = 0;
+	for (const Node *node : nodes_)
+		linkCount += node->links_.size();
+	targets.reserve(linkCount);
+	weights.reserve(linkCount);
+
+	for (unsigned id = 0; id < n; id++) {
+		const Node *node = nodes_[order[id]];
+		points[id] = node->point_;
+		offsets[id] = (unsigned)targets.size();
+
+		for (const std::pair<Node *, int> &link : node->links_) {
+			targets.push_back(newId[link.first->id_]);
+			weights.push_back(link.second);
+		}
+	}
+	offsets[n] = (unsigned)targets.size();
+
+	return FrozenGraph(std::move(points), std::move(offsets), std::move(targets), std::move(weights));
 }
@@ -1,15 +1,20 @@
 #pragma once
 #include <vector>
 #include <unordered_map>
+#include "pathfind.h"
 #include "pointTypes.h"
 
+class FrozenGraph;
+
 // TODO: use to turn into templates
 // point in nDimensional space, can also contain any associated data
 typedef Point2D PointT; 
 
 // graph of any nDimensional space
-// supports A* pathfinding
+// supports Dijkstra and A* pathfinding
 class Graph {
+	friend class Pathfinder;
+
 protected:
 	// individual node in graph, refering to a point in space of type PointT
 	// contains links to other nodes in graph, and weight of each link
@@ -19,12 +24,29 @@ protected:
 	// map of all points in graph
 	std::unordered_map<PointT, Node> map_;
 
+	// every node, by id, so pathfinding can keep its state in flat arrays instead of maps keyed by point
+	std::vector<Node *> nodes_;
+
+protected:
+	// node of a point, inserting it if it isn't in graph
+	Node * nodeOf_(const PointT &point);
+
+	// for Pathfinder
+	unsigned nodeCount_() const { return (unsigned)nodes_.size(); }
+	template<typename FuncT>
+	void forEachLink_(unsigned id, FuncT fn) const;
+	const PointT & pointOf_(unsigned id) const;
+
+	// points from start to goal of the path the last search found
+	std::vector<PointT> pathOf_(unsigned start, unsigned goal) const;
+
 public:
 	// inserts a point into graph
 	// true if insertion was successful
 	bool insert(const PointT &point);
 
 	// removes a point from graph after unlinking it
+	// the last node inserted takes over its id
 	// false if point wasn't in graph
 	bool remove(const PointT &point);
 
@@ -42,10 +64,27 @@ public:
 	// will be empty if node does not exist
 	const std::vector<std::pair<Node *, int>> linksOf(const PointT &p) const;
 
+	// copies the graph into a FrozenGraph, declared in frozengraph.h, an immutable compressed sparse row layout
+	// that pathfinds without hashing points or chasing pointers, O(V + E)
+	FrozenGraph freeze() const;
+
 public:
-	// finds a short path from start to end
+	// finds the shortest path from start to end, O((V + E) log V) with a binary heap
+	// link weights must not be negative, a radix heap avoids comparing distances and suits small weights
+	// search state is kept per thread and reused, so a query only touches the nodes it explores
+	// returned vector will be empty if no path was found
+	std::vector<PointT> pathfindDijkstra(const PointT &start, const PointT &goal, PathfindQueue queue = PathfindQueue::BinaryHeap) const;
+
+	// finds a path from start to goal, guided by heuristic(point, goal), see pointTypes.h for built in heuristics
+	// shortest if the heuristic never overestimates the cost between two points, then weight > 1 trades
+	// path length for speed, exploring fewer nodes for a path at most weight times longer
+	// nodes are reopened when a shorter way to them turns up, so only consistent heuristics explore each node once
 	// returned vector will be empty if no path was found
-	std::vector<PointT> pathfindDijkstra(const PointT &start, const PointT &goal) const;
+	template<typename HeuristicT = EuclideanHeuristic>
+	std::vector<PointT> pathfindAStar(const PointT &start, const PointT &goal, HeuristicT heuristic = HeuristicT(), double weight = 1) const;
+
+	// number of nodes the last pathfind on this thread explored, to measure how much searching a heuristic saves
+	static unsigned lastExpanded();
 };
 
 
@@ -78,6 +117,9 @@ protected:
 	// point this node represents
 	PointT point_;
 
+	// index of this node in the graph's nodes_
+	unsigned id_;
+
 	// any neighbors this node might have and a weight to get to them
 	std::vector<std::pair<Node *, int>> links_;
 
@@ -88,4 +130,28 @@ private:
 
 	// removes only this node's link to another graph node
 	void unlinkThis(Node *n);
-};
\ No newline at end of file
+};
+
+
+
+template<typename FuncT>
+inline void Graph::forEachLink_(unsigned id, FuncT fn) const {
+	for (const std::pair<Node *, int> &link : nodes_[id]->links_)
+		fn(link.first->id_, link.second);
+}
+
+inline const PointT & Graph::pointOf_(unsigned id) const {
+	return nodes_[id]->point_;
+}
+
+template<typename HeuristicT>
+std::vector<PointT> Graph::pathfindAStar(const PointT &start, const PointT &goal, HeuristicT heuristic, double weight) const {
+	auto startNode = map_.find(start), goalNode = map_.find(goal);
+	if (startNode == map_.end() || goalNode == map_.end())
+		return std::vector<PointT>();
+
+	unsigned startId = (*startNode).second.id_, goalId = (*goalNode).second.id_;
+	if (!Pathfinder::local().aStar(*this, startId, goalId, heuristic, weight))
+		return std::vector<PointT>();
+	return pathOf_(startId, goalId);
+}
\ No newline at end of file
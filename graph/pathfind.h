@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "radixheap.h"
+
+// Pathfinder
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// shortest path searches over any graph whose nodes are numbered 0 through n - 1
+// GraphT must provide, to Pathfinder as a friend:
+//   unsigned nodeCount_() const                   number of node ids
+//   void forEachLink_(unsigned id, FuncT fn) const calls fn(unsigned neighbor, int weight) for every link out of id
+//   pointOf_(unsigned id) const                    point of a node, only for aStar(), passed to the heuristic
+//
+// distances and parents are kept in flat arrays indexed by id, which are reused from one search to the next.
+// instead of clearing them, every node is stamped with the number of the search that last reached it,
+// so a search only costs as much as the part of the graph it explores
+// weights must not be negative
+
+// which priority queue dijkstra() orders nodes with
+enum class PathfindQueue {
+	BinaryHeap, // general purpose
+	RadixHeap   // no comparisons between keys, faster when distances stay small
+};
+
+class Pathfinder {
+protected:
+	// entry in the binary heap, ordered smallest distance first
+	typedef std::pair<int, unsigned> HeapEntry;
+	// entry in the A* heap, ordered smallest estimated total first
+	typedef std::pair<double, unsigned> EstimateEntry;
+
+protected:
+	std::vector<int> distance_;       // shortest distance found from start
+	std::vector<unsigned> parent_;    // node before each node on its shortest path
+	std::vector<unsigned> reached_;   // search that last gave the node a distance
+	std::vector<unsigned> closed_;    // search that last took the node off the queue, its distance is final
+	unsigned search_;                 // number of the current search, never 0
+	unsigned expanded_;               // nodes taken off the queue by the last search
+
+	std::vector<HeapEntry> heap_;
+	RadixHeap<unsigned> radixHeap_;
+	std::vector<EstimateEntry> estimateHeap_;
+
+protected:
+	// starts a new search over the given number of nodes
+	void begin_(unsigned nodes);
+
+	// true if a node has a distance in the current search
+	bool isReached_(unsigned id) const { return reached_[id] == search_; }
+
+	// gives a node a new distance and parent if the distance is shorter than its current one, true if it was
+	bool relax_(unsigned id, unsigned parent, int distance);
+
+	template<typename GraphT, typename PopT, typename PushT>
+	bool dijkstra_(const GraphT &graph, unsigned start, unsigned goal, PopT pop, PushT push);
+
+public:
+	Pathfinder();
+
+	// search state of the calling thread, shared by every graph it searches
+	// kept between queries, so its arrays only grow to the largest graph searched
+	static Pathfinder & local();
+
+	// finds the shortest distance from start to goal
+	// true if goal can be reached from start
+	template<typename GraphT>
+	bool dijkstra(const GraphT &graph, unsigned start, unsigned goal, PathfindQueue queue = PathfindQueue::BinaryHeap);
+
+	// finds a path from start to goal, exploring nodes in order of distance + weight * heuristic(point, goal point)
+	// the path is the shortest if weight is 1 and the heuristic never overestimates, a larger weight
+	// explores fewer nodes for a path at most weight times longer
+	// a closed node is reopened if a shorter distance to it is found, which a consistent heuristic never causes
+	// but one that only never overestimates can
+	// true if goal can be reached from start
+	template<typename GraphT, typename HeuristicT>
+	bool aStar(const GraphT &graph, unsigned start, unsigned goal, HeuristicT heuristic, double weight = 1);
+
+	// ids from start to goal of the path found by the last search, which must have reached goal
+	std::vector<unsigned> path(unsigned start, unsigned goal) const;
+
+	// distance from start of a node in the last search, INT_MAX if it wasnt reached
+	int distance(unsigned id) const { return (id < reached_.size() && isReached_(id)) ? distance_[id] : INT_MAX; }
+
+	// number of nodes the last search took off its queue
+	unsigned expanded() const { return expanded_; }
+};
+
+
+
+inline Pathfinder::Pathfinder() : search_(0), expanded_(0) {
+}
+
+inline Pathfinder & Pathfinder::local() {
+	static thread_local Pathfinder pathfinder;
+	return pathfinder;
+}
+
+inline void Pathfinder::begin_(unsigned nodes) {
+	if (reached_.size() < nodes) {
+		distance_.resize(nodes);
+		parent_.resize(nodes);
+		reached_.resize(nodes, 0);
+		closed_.resize(nodes, 0);
+	}
+
+	// stamps only need clearing once they run out
+	if (++search_ == 0) {
+		std::fill(reached_.begin(), reached_.end(), 0);
+		std::fill(closed_.begin(), closed_.end(), 0);
+		search_ = 1;
+	}
+	expanded_ = 0;
+}
+
+inline bool Pathfinder::relax_(unsigned id, unsigned parent, int distance) {
+	if (isReached_(id) && distance_[id] <= distance)
+		return false;
+
+	reached_[id] = search_;
+	distance_[id] = distance;
+	parent_[id] = parent;
+	return true;
+}
+
+template<typename GraphT, typename PopT, typename PushT>
+bool Pathfinder::dijkstra_(const GraphT &graph, unsigned start, unsigned goal, PopT pop, PushT push) {
+	relax_(start, start, 0);
+	push(0, start);
+
+	unsigned current;
+	while (pop(current)) {
+		// nodes are pushed again instead of decreasing their key, the later copies are skipped
+		if (closed_[current] == search_)
+			continue;
+		closed_[current] = search_;
+		expanded_++;
+
+		if (current == goal)
+			return true;
+
+		int distance = distance_[current];
+		graph.forEachLink_(current, [&](unsigned neighbor, int weight) {
+			if (closed_[neighbor] != search_ && relax_(neighbor, current, distance + weight))
+				push(distance + weight, neighbor);
+		});
+	}
+	return false;
+}
+
+template<typename GraphT>
+bool Pathfinder::dijkstra(const GraphT &graph, unsigned start, unsigned goal, PathfindQueue queue) {
+	begin_(graph.nodeCount_());
+
+	if (queue == PathfindQueue::RadixHeap) {
+		radixHeap_.clear();
+		return dijkstra_(graph, start, goal,
+			[&](unsigned &id) {
+				if (radixHeap_.empty())
+					return false;
+				id = radixHeap_.pop().second;
+				return true;
+			},
+			[&](int distance, unsigned id) { radixHeap_.push((unsigned)distance, id); });
+	}
+
+	heap_.clear();
+	return dijkstra_(graph, start, goal,
+		[&](unsigned &id) {
+			if (heap_.empty())
+				return false;
+			std::pop_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+			id = heap_.back().second;
+			heap_.pop_back();
+			return true;
+		},
+		[&](int distance, unsigned id) {
+			heap_.emplace_back(distance, id);
+			std::push_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+		});
+}
+
+template<typename GraphT, typename HeuristicT>
+bool Pathfinder::aStar(const GraphT &graph, unsigned start, unsigned goal, HeuristicT heuristic, double weight) {
+	begin_(graph.nodeCount_());
+	estimateHeap_.clear();
+
+	const auto &goalPoint = graph.pointOf_(goal);
+	auto push = [&](int distance, unsigned id) {
+		estimateHeap_.emplace_back(distance + weight * heuristic(graph.pointOf_(id), goalPoint), id);
+		std::push_heap(estimateHeap_.begin(), estimateHeap_.end(), std::greater<EstimateEntry>());
+	};
+
+	relax_(start, start, 0);
+	push(0, start);
+
+	while (!estimateHeap_.empty()) {
+		std::pop_heap(estimateHeap_.begin(), estimateHeap_.end(), std::greater<EstimateEntry>());
+		unsigned current = estimateHeap_.back().second;
+		estimateHeap_.pop_back();
+
+		if (closed_[current] == search_)
+			continue;
+		closed_[current] = search_;
+		expanded_++;
+
+		if (current == goal)
+			return true;
+
+		int distance = distance_[current];
+		graph.forEachLink_(current, [&](unsigned neighbor, int linkWeight) {
+			if (relax_(neighbor, current, distance + linkWeight)) {
+				closed_[neighbor] = 0;
+				push(distance + linkWeight, neighbor);
+			}
+		});
+	}
+	return false;
+}
+
+inline std::vector<unsigned> Pathfinder::path(unsigned start, unsigned goal) const {
+	std::vector<unsigned> path;
+	path.push_back(goal);
+
+	// start from goal, then trace its parents back to start
+	while (path.back() != start)
+		path.push_back(parent_[path.back()]);
+
+	std::reverse(path.begin(), path.end());
+	return path;
+}
@@ -1,5 +1,7 @@
 #include "pointTypes.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 
 
 Point2D::Point2D(int x, int y) 
@@ -12,6 +14,19 @@ double Point2D::directDistance(const Point2D & n) const {
 	return sqrt((dX * dX) + (dY * dY));
 }
 
+int Point2D::manhattanDistance(const Point2D & n) const {
+	return std::abs(x - n.x) + std::abs(y - n.y);
+}
+
+double Point2D::octileDistance(const Point2D & n) const {
+	int dX = std::abs(x - n.x),
+		dY = std::abs(y - n.y);
+	int dMax = (dX > dY) ? dX : dY,
+		dMin = (dX > dY) ? dY : dX;
+	// dMin diagonal steps, then the rest straight
+	return dMax + (sqrt(2.0) - 1) * dMin;
+}
+
 bool Point2D::operator==(const Point2D & n) const { return (x == n.x) && (y == n.y); }
 bool Point2D::operator!=(const Point2D & n) const { return !operator==(n); }
 
@@ -28,5 +43,16 @@ double Point3D::directDistance(const Point3D & n) const {
 	return sqrt((dX * dX) + (dY * dY) + (dZ * dZ));
 }
 
+int Point3D::manhattanDistance(const Point3D & n) const {
+	return std::abs(x - n.x) + std::abs(y - n.y) + std::abs(z - n.z);
+}
+
+double Point3D::octileDistance(const Point3D & n) const {
+	int d[3] = { std::abs(x - n.x), std::abs(y - n.y), std::abs(z - n.z) };
+	std::sort(d, d + 3);
+	// d[0] steps across all 3 axes, d[1] - d[0] across 2, the rest straight
+	return d[2] + (sqrt(2.0) - 1) * d[1] + (sqrt(3.0) - sqrt(2.0)) * d[0];
+}
+
 bool Point3D::operator==(const Point3D & n) const { return (x == n.x) && (y == n.y) && (z == n.z); }
 bool Point3D::operator!=(const Point3D & n) const { return !operator==(n); }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <functional>
 
 // a point for a 2d graph
@@ -8,6 +9,10 @@ struct Point2D {
 	Point2D(int x = 0, int y = 0);
 
 	double directDistance(const Point2D &n) const;
+	// distance moving only along axes
+	int manhattanDistance(const Point2D &n) const;
+	// distance moving along axes and diagonals, with diagonal steps costing sqrt(2)
+	double octileDistance(const Point2D &n) const;
 
 	bool operator==(const Point2D &n) const;
 	bool operator!=(const Point2D &n) const;
@@ -20,30 +25,73 @@ struct Point3D {
 	Point3D(int x = 0, int y = 0, int z = 0);
 
 	double directDistance(const Point3D &n) const;
+	// distance moving only along axes
+	int manhattanDistance(const Point3D &n) const;
+	// distance moving along axes and diagonals, with steps across 2 axes costing sqrt(2) and across 3 sqrt(3)
+	double octileDistance(const Point3D &n) const;
 
 	bool operator==(const Point3D &n) const;
 	bool operator!=(const Point3D &n) const;
 };
 
 
+// estimates of the cost between two points for A*, scale converts a distance into link weights
+// a heuristic keeps A* optimal as long as it never estimates more than the cheapest path costs, and is consistent
+// if for every link from a to b it never drops by more than the link's weight, then A* never reopens a node
+// each of these is both while scale times its distance across any link is at most that link's weight,
+// on a grid of 1 apart points that is scale <= the lightest axis link, and with diagonal links also
+// scale * 2 for manhattan, or scale * sqrt(2) for the others, <= the lightest diagonal link
+
+// straight line distance, for graphs where links can go in any direction
+struct EuclideanHeuristic {
+	double scale;
+	EuclideanHeuristic(double scale = 1) : scale(scale) {}
+
+	template<typename P>
+	double operator()(const P &a, const P &b) const { return scale * a.directDistance(b); }
+};
+
+// axis aligned distance, for grids linked only to their axis neighbors
+struct ManhattanHeuristic {
+	double scale;
+	ManhattanHeuristic(double scale = 1) : scale(scale) {}
+
+	template<typename P>
+	double operator()(const P &a, const P &b) const { return scale * a.manhattanDistance(b); }
+};
+
+// diagonal distance, for grids also linked to their diagonal neighbors
+struct OctileHeuristic {
+	double scale;
+	OctileHeuristic(double scale = 1) : scale(scale) {}
+
+	template<typename P>
+	double operator()(const P &a, const P &b) const { return scale * a.octileDistance(b); }
+};
+
+
+// mixes a 64 bit value so every bit of the result depends on every bit of it, splitmix64's finalizer
+inline std::size_t pointHashMix(std::uint64_t v) {
+	v = (v ^ (v >> 30)) * 0xbf58476d1ce4e5b9ull;
+	v = (v ^ (v >> 27)) * 0x94d049bb133111ebull;
+	return (std::size_t)(v ^ (v >> 31));
+}
+
 // allows points to be hashed
+// coordinates are packed into one 64 bit value and mixed, so negative ones spread as well as positive ones
 namespace std {
 	template<> 
 	struct hash<Point2D>	{
-		// generates a "unique" index using cantor pairing
 		std::size_t operator()(const Point2D &s) const noexcept {
-			int xPlusY = s.x + s.y;
-			return s.y + ((xPlusY) * (xPlusY + 1)) / 2 ;
+			return pointHashMix(((std::uint64_t)(std::uint32_t)s.x << 32) | (std::uint32_t)s.y);
 		}
 	};
 
 	template<> 
 	struct hash<Point3D> {
-		// its just cantor pairing twice.
 		std::size_t operator()(const Point3D &s) const noexcept {
-			int xPlusY = s.x + s.y;
-			int zPlusXPairedY = s.y + ((xPlusY) * (xPlusY + 1)) / 2 + s.z;
-			return s.z + ((zPlusXPairedY) * (zPlusXPairedY + 1)) / 2;
+			std::uint64_t xy = ((std::uint64_t)(std::uint32_t)s.x << 32) | (std::uint32_t)s.y;
+			return pointHashMix(pointHashMix(xy) ^ (std::uint32_t)s.z);
 		}
 	};
 };
\ No newline at end of file
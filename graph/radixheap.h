@@ -0,0 +1,104 @@
+#pragma once
+#include <utility>
+#include <vector>
+
+// Radix Heap
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// a monotone priority queue of unsigned keys, where every key pushed is at least the last key popped,
+// as in Dijkstra's algorithm with non negative weights
+// bucket i holds keys whose highest bit differing from the last popped key is bit i - 1, bucket 0 holds keys equal to it
+// when bucket 0 runs out, the lowest non empty bucket is spread into the buckets below its smallest key,
+// so each element moves down at most 32 times, and pushing and popping are O(1) amortized with no comparisons
+// between elements. buckets keep their memory when cleared, so a heap reused for many searches stops allocating
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RADIX_HEAP_CLZ(x) ((unsigned)__builtin_clz(x))
+#endif
+
+template<typename ValueT>
+class RadixHeap {
+protected:
+	static const unsigned BucketCount = sizeof(unsigned) * 8 + 1;
+
+	std::vector<std::pair<unsigned, ValueT>> buckets_[BucketCount];
+	unsigned last_; // last key popped, every key in the heap is at least this
+	unsigned size_;
+
+protected:
+	// bucket a key goes in, relative to last_
+	unsigned bucketOf_(unsigned key) const;
+
+public:
+	RadixHeap() : last_(0), size_(0) {}
+
+	// number of elements in heap
+	unsigned size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	// adds a value, key must be at least the last key popped
+	void push(unsigned key, const ValueT &value);
+
+	// removes a value with the smallest key, the heap must not be empty
+	std::pair<unsigned, ValueT> pop();
+
+	// removes every element and lets keys start over from 0, keeps the buckets' memory
+	void clear();
+};
+
+
+
+template<typename ValueT>
+inline unsigned RadixHeap<ValueT>::bucketOf_(unsigned key) const {
+	unsigned diff = key ^ last_;
+	if (diff == 0)
+		return 0;
+
+#ifdef RADIX_HEAP_CLZ
+	return BucketCount - 1 - RADIX_HEAP_CLZ(diff);
+#else
+	unsigned bucket = 0;
+	for (; diff != 0; diff >>= 1)
+		bucket++;
+	return bucket;
+#endif
+}
+
+template<typename ValueT>
+inline void RadixHeap<ValueT>::push(unsigned key, const ValueT &value) {
+	buckets_[bucketOf_(key)].emplace_back(key, value);
+	size_++;
+}
+
+template<typename ValueT>
+std::pair<unsigned, ValueT> RadixHeap<ValueT>::pop() {
+	if (buckets_[0].empty()) {
+		unsigned i = 1;
+		while (buckets_[i].empty())
+			i++;
+
+		// every key in the bucket differs from the new last_ in a lower bit than i - 1, so they all move down
+		std::vector<std::pair<unsigned, ValueT>> &bucket = buckets_[i];
+		unsigned min = bucket[0].first;
+		for (const std::pair<unsigned, ValueT> &e : bucket)
+			min = (e.first < min) ? e.first : min;
+
+		last_ = min;
+		for (const std::pair<unsigned, ValueT> &e : bucket)
+			buckets_[bucketOf_(e.first)].push_back(e);
+		bucket.clear();
+	}
+
+	std::pair<unsigned, ValueT> top = buckets_[0].back();
+	buckets_[0].pop_back();
+	size_--;
+	return top;
+}
+
+template<typename ValueT>
+void RadixHeap<ValueT>::clear() {
+	for (unsigned i = 0; i < BucketCount; i++)
+		buckets_[i].clear();
+	last_ = 0;
+	size_ = 0;
+}
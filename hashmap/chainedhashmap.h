@@ -1,32 +1,101 @@
 #pragma once
-#include <list>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "../nodepool/nodepool.h"
 
 // A chained hashmap
 // Written by ItsNorin      https://github.com/ItsNorin/
+//
+// chains are singly linked lists of nodes taken from a pool owned by the map,
+// resizing relinks the existing nodes instead of copying them, and removed nodes are reused
 
 #define HASHMAP_BASIC_SIZE 64 // default starting size for hashmap
 #define LONGEST_ACCEPTABLE_CHAIN_LENGTH 4 // longest length any chain can be, will re-size table when a chain exceeds this limit
 #define GROWTH_RATE 3/2 // new table size will be the number of elements it currently holds * GROWTH_RATE
+#define HASHMAP_MIGRATION_STEP 4 // default number of old buckets moved per operation while incrementally resizing
+#define HASHMAP_BATCH_SIZE 8 // number of keys findBatch and insertBatch keep between each prefetching stage
 
-template<typename KeyT, typename DataT>
+// hints the cpu to start loading the cache line at ptr
+#if defined(__GNUC__) || defined(__clang__)
+#define HASHMAP_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define HASHMAP_PREFETCH(ptr) _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+#else
+#define HASHMAP_PREFETCH(ptr) ((void)0)
+#endif
+
+// full hash of a chain node's key, kept in the node so resizing never rehashes
+// and chain scans only compare keys whose hashes match
+template<bool StoreHash>
+struct ChainedHashCode {
+	std::size_t hash;
+
+	ChainedHashCode(std::size_t hash) : hash(hash) {}
+
+	void setHash(std::size_t h) { hash = h; }
+
+	bool hashMatches(std::size_t h) const { return hash == h; }
+
+	template<typename HashT, typename KeyT>
+	std::size_t hashOf(const HashT &, const KeyT &) const { return hash; }
+};
+
+// nothing is stored, the hash is recomputed when needed
+template<>
+struct ChainedHashCode<false> {
+	ChainedHashCode(std::size_t) {}
+
+	void setHash(std::size_t) {}
+
+	bool hashMatches(std::size_t) const { return true; }
+
+	template<typename HashT, typename KeyT>
+	std::size_t hashOf(const HashT &hasher, const KeyT &key) const { return hasher(key); }
+};
+
+// true if both HashT and KeyEqualT accept keys of other types, marked by an is_transparent member type
+// lets a map with std::string keys be searched with a std::string_view, without building a string
+template<typename HashT, typename KeyEqualT, typename = void>
+struct ChainedHashTransparent : std::false_type {};
+
+template<typename HashT, typename KeyEqualT>
+struct ChainedHashTransparent<HashT, KeyEqualT, std::void_t<typename HashT::is_transparent, typename KeyEqualT::is_transparent>> 
+	: std::true_type {};
+
+
+// HashT and KeyEqualT are function objects hashing a key into a std::size_t and comparing two keys
+// if StoreHash, each entry keeps its full hash, worth it whenever hashing or comparing keys is expensive
+template<typename KeyT, typename DataT, 
+	typename HashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>, bool StoreHash = !std::is_arithmetic<KeyT>::value>
 class ChainedHashMap {
 public:
 	// element in hashmap
 	struct Entry {
 		KeyT key;
 		DataT data;
-		Entry(KeyT key, DataT data) : key(key), data(data) {}
+
+		template<typename K, typename D>
+		Entry(K &&key, D &&data) : key(std::forward<K>(key)), data(std::forward<D>(data)) {}
+
+		// constructs key from key, and data from args
+		template<typename K, typename... Args>
+		Entry(std::piecewise_construct_t, K &&key, Args&&... args) : key(std::forward<K>(key)), data(std::forward<Args>(args)...) {}
 	};
 
 public:
 	// creates a hashmap
-	// must be given a hasher function, which can hash the key into an unsigned integer
 	//
 	// hasher should return a value >= the number of entries the hashmap is going to store, 
 	// which should aim to distribute the entries evenly throughout the table
 	//
 	// size is the starting width of the hashmap, will change if the hashmap gets a chain longer than LONGEST_ACCEPTABLE_CHAIN_LENGTH
-	ChainedHashMap(unsigned(*hasher)(const KeyT &), unsigned size = HASHMAP_BASIC_SIZE);
+	ChainedHashMap(unsigned size = HASHMAP_BASIC_SIZE, const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	// creates a hashmap with the given hasher
+	ChainedHashMap(const HashT &hasher, unsigned size = HASHMAP_BASIC_SIZE);
 
 	// copy an existing hashmap
 	ChainedHashMap(const ChainedHashMap &map);
@@ -36,17 +105,63 @@ public:
 	// insert an entry into hashmap
 	// if the hashmap has become overpopulated, will resize to increase searching efficency
 	// true if inserted, false if key already exists
+	// nothing is copied or moved if the key already exists
 	bool insert(const Entry &e);
+	bool insert(Entry &&e);
 	// insert element into hashmap by key and its data
-	bool insert(const KeyT key, const DataT data);
+	bool insert(const KeyT &key, const DataT &data);
+	bool insert(KeyT &&key, DataT &&data);
+
+	// constructs an entry in place from args, the same as Entry's constructor would take
+	// the entry has to be built to know its key, so it is built and destroyed again if the key already exists
+	// returns pointer to the key's data, and true if inserted
+	template<typename... Args>
+	std::pair<DataT *, bool> emplace(Args&&... args);
+
+	// constructs an entry's data in place from args, only if key doesnt already exist
+	// returns pointer to the key's data, and true if inserted
+	template<typename... Args>
+	std::pair<DataT *, bool> tryEmplace(const KeyT &key, Args&&... args);
+	template<typename... Args>
+	std::pair<DataT *, bool> tryEmplace(KeyT &&key, Args&&... args);
+
+	// inserts an entry, or assigns data to the key's existing data
+	// returns pointer to the key's data, and true if inserted, false if assigned
+	template<typename D>
+	std::pair<DataT *, bool> insertOrAssign(const KeyT &key, D &&data);
+	template<typename D>
+	std::pair<DataT *, bool> insertOrAssign(KeyT &&key, D &&data);
 
 	// remove a key from hashmap
 	// true if removed, false if not found
-	bool remove(KeyT key);
+	bool remove(const KeyT &key);
+	// remove by any key type, if hasher and key equality are transparent
+	template<typename K, typename H = HashT, typename = typename std::enable_if<ChainedHashTransparent<H, KeyEqualT>::value>::type>
+	bool remove(const K &key);
 
 	// search for the data associated with the given key
 	// returns pointer to key's associated data if found, if not found, returns nullptr
-	DataT * find(KeyT key) const;
+	// while migrating, find moves buckets like any other operation, so even concurrent finds need a lock then
+	DataT * find(const KeyT &key) const;
+	// search by any key type, if hasher and key equality are transparent
+	template<typename K, typename H = HashT, typename = typename std::enable_if<ChainedHashTransparent<H, KeyEqualT>::value>::type>
+	DataT * find(const K &key) const;
+
+	// inserts n entries, same as calling insert on each
+	// every key is hashed and its bucket and first node are prefetched well before it is inserted,
+	// so the cache misses of independent inserts overlap instead of being paid one after another
+	// inserted, if given, is set to whether each entry was inserted
+	// returns number of entries inserted
+	unsigned insertBatch(const Entry *entries, std::size_t n, bool *inserted = nullptr);
+
+	// searches for n keys, same as calling find on each, writing the results into out
+	// every key is hashed and its bucket and first node are prefetched well before it is resolved
+	// returns number of keys found
+	unsigned findBatch(const KeyT *keys, std::size_t n, DataT **out) const;
+
+	// calls fn(const Entry &) on every entry, in no particular order
+	template<typename FuncT>
+	void forEach(FuncT fn) const;
 
 	// number of entries hashmap is storing
 	unsigned entries() const;
@@ -62,24 +177,112 @@ public:
 
 	// resizes to given size unless it is too small to hold all entries 
 	// while keeping longestChain below LONGEST_ACCEPTABLE_CHAIN_LENGTH
-	// returns true if resized, otherwise false
+	// returns true if resized or waiting to be, otherwise false
 	bool resize(unsigned newTableSize);
 
+	// when enabled, a resize only allocates the new table, and every following insert, remove and find
+	// moves migrationStep() buckets of the old table into it, so no single operation pays for the whole rehash
+	// a resize asked for while migrating waits for the migration to finish, only the latest one asked for is kept
+	// disabled by default
+	void incrementalResize(bool enabled);
+	bool incrementalResize() const;
+
+	// number of old buckets moved per operation while migrating
+	void migrationStep(unsigned buckets);
+	unsigned migrationStep() const;
+
+	// true while entries are still being moved from the old table
+	bool migrating() const;
+
+	// fraction of the old table that has been moved, 1 when not migrating
+	float migrationProgress() const;
+
+	// moves every entry left in the old table right away, along with any resize that was waiting on it
+	void finishMigration();
+
+protected:
+	// link in a chain
+	struct Node : ChainedHashCode<StoreHash> {
+		Entry entry;
+		Node *next;
+
+		// constructs entry from args
+		template<typename... Args>
+		Node(std::size_t hash, Args&&... args) : ChainedHashCode<StoreHash>(hash), entry(std::forward<Args>(args)...), next(nullptr) {}
+	};
+
 protected:
-	// hashmap body
-	std::list<Entry> *table_;
+	// hashmap body, first node of each chain
+	Node **table_;
 	unsigned tableSize_;
 
-	// hashing function, must convert key to an unsigned int
-	unsigned(*hasher_)(const KeyT &);
+	// table being migrated from during an incremental resize, nullptr otherwise
+	// buckets below migratedBuckets_ have already been moved and are empty
+	mutable Node **oldTable_;
+	unsigned oldTableSize_;
+	mutable unsigned migratedBuckets_;
+
+	bool incremental_;
+	unsigned migrationStep_;
+
+	// size of a resize asked for while migrating, started once the migration finishes, 0 if none
+	unsigned pendingTableSize_;
+
+	// hashing function, must convert key to a std::size_t
+	HashT hasher_;
+
+	// true if two keys are the same
+	KeyEqualT keyEqual_;
 
 	// number of elements hashmap is storing
 	unsigned entryCount_;
 
-	// longest chain, used to resize hashmap
+	// longest chain in table_ since it was last resized, used to resize hashmap
 	unsigned longestChainLength_;
 
+	// every node in the hashmap comes from here
+	NodePool<Node> pool_;
+
 protected:
+	// chain a key belongs in, the old table's if that bucket has not been migrated yet
+	// inOldTable is set to whether the old table's chain was chosen
+	Node *& chainOf_(std::size_t hash, bool *inOldTable = nullptr) const;
+
+	// moves up to the given number of buckets from the old table, freeing it once all are moved
+	// nodes are relinked, so pointers returned by find stay valid
+	void migrate_(unsigned buckets) const;
+
+	// moves one migration step, then starts the waiting resize if that finished the migration
+	void step_();
+
+	// relinks every node of a chain onto the front of its chain in table_
+	void relinkChain_(Node *chain) const;
+
+	// link to the node holding key, or the empty link at the end of its chain if not found
+	// chainLength is set to the chain's length once a node is added, inOldTable to whether it is in the old table
+	template<typename K>
+	Node ** findLink_(const K &key, std::size_t hash, unsigned &chainLength, bool &inOldTable) const;
+
+	// links a new node onto the empty link found by findLink_, resizing if the chain got too long
+	void linkNode_(Node **link, Node *n, unsigned chainLength, bool inOldTable);
+
+	// if key doesnt exist, inserts a node built with its key from key and its data from args
+	// hash must already be computed
+	template<typename K, typename... Args>
+	std::pair<DataT *, bool> tryEmplaceHashed_(K &&key, std::size_t hash, Args&&... args);
+
+	// node in chain holding key, nullptr if not found
+	template<typename K>
+	Node * findInChain_(Node *chain, const K &key, std::size_t hash) const;
+
+	// finds key's data, nullptr if not found
+	template<typename K>
+	DataT * find_(const K &key) const;
+
+	// finds and removes key
+	template<typename K>
+	bool remove_(const K &key);
+
 	// forces table to resize to given size
 	// table will re-size itsself again if a new entry is inserted and 
 	// longestChainLength exceeds LONGEST_ACCEPTABLE_CHAIN_LENGTH
@@ -88,129 +291,489 @@ protected:
 
 
 
-template<typename KeyT, typename DataT>
-ChainedHashMap<KeyT, DataT>::ChainedHashMap(unsigned(*hasher)(const KeyT &), unsigned size)
-	: hasher_(hasher), table_(new std::list<Entry>[size]), tableSize_(size), entryCount_(0), longestChainLength_(0)
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::ChainedHashMap(unsigned size, const HashT &hasher, const KeyEqualT &keyEqual)
+	: table_(new Node*[size]()), tableSize_(size), 
+	  oldTable_(nullptr), oldTableSize_(0), migratedBuckets_(0), incremental_(false), migrationStep_(HASHMAP_MIGRATION_STEP), pendingTableSize_(0),
+	  hasher_(hasher), keyEqual_(keyEqual), entryCount_(0), longestChainLength_(0)
+{}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::ChainedHashMap(const HashT &hasher, unsigned size)
+	: ChainedHashMap(size, hasher)
 {}
 
-template<typename KeyT, typename DataT>
-inline ChainedHashMap<KeyT, DataT>::ChainedHashMap(const ChainedHashMap &map) 
-	: hasher_(map.hasher_), table_(new std::list<Entry>[map.tableSize_]), tableSize_(map.tableSize_), 
-	  entryCount_(map.entryCount_), longestChainLength_(map.longestChainLength_) 
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::ChainedHashMap(const ChainedHashMap &map) 
+	: table_(new Node*[map.tableSize_]()), tableSize_(map.tableSize_), 
+	  oldTable_(nullptr), oldTableSize_(0), migratedBuckets_(0), incremental_(map.incremental_), migrationStep_(map.migrationStep_), pendingTableSize_(0),
+	  hasher_(map.hasher_), keyEqual_(map.keyEqual_), entryCount_(map.entryCount_), longestChainLength_(map.longestChainLength_) 
 {
-	for (unsigned i = 0; i < tableSize_; i++) {
-		std::list<Entry> &list = map.table_[i];
-		for (auto it = list.begin(); it != list.end(); ++it)
-			table_[hasher_((*it).key) % tableSize_].push_back((*it));
+	pool_.reserve(entryCount_);
+
+	// copies every chain, including anything the copied map had not migrated yet, straight into the new table
+	for (int t = 0; t < 2; t++) {
+		Node **table = (t == 0) ? map.table_ : map.oldTable_;
+		unsigned first = (t == 0) ? 0 : map.migratedBuckets_;
+		unsigned last = (t == 0) ? map.tableSize_ : map.oldTableSize_;
+
+		for (unsigned i = first; table != nullptr && i < last; i++) {
+			for (Node *n = table[i]; n != nullptr; n = n->next) {
+				std::size_t hash = n->hashOf(hasher_, n->entry.key);
+				Node *&chain = table_[hash % tableSize_];
+				Node *copy = new (pool_.allocate()) Node(hash, n->entry);
+				copy->next = chain;
+				chain = copy;
+			}
+		}
 	}
 }
 
 
-template<typename KeyT, typename DataT>
-ChainedHashMap<KeyT, DataT>::~ChainedHashMap() {
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::~ChainedHashMap() {
+	// nodes are released along with the pool, only their entries may need destroying
+	if (!std::is_trivially_destructible<Entry>::value) {
+		for (int t = 0; t < 2; t++) {
+			Node **table = (t == 0) ? table_ : oldTable_;
+			unsigned size = (t == 0) ? tableSize_ : oldTableSize_;
+
+			for (unsigned i = 0; table != nullptr && i < size; i++) {
+				for (Node *n = table[i]; n != nullptr; n = n->next)
+					n->entry.~Entry();
+			}
+		}
+	}
 	delete[] table_;
+	delete[] oldTable_;
 }
 
 
 
-template<typename KeyT, typename DataT>
-inline bool ChainedHashMap<KeyT, DataT>::insert(const Entry &e) {
-	std::list<Entry> &chosenList = table_[hasher_(e.key) % tableSize_];
-	// ensure key doesnt exist in table
-	for (auto it = chosenList.begin(); it != chosenList.end(); ++it) {
-		if ((*it).key == e.key)
-			return false;
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K>
+inline typename ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Node ** 
+ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::findLink_(const K &key, std::size_t hash, unsigned &chainLength, bool &inOldTable) const {
+	Node **link = &chainOf_(hash, &inOldTable);
+	chainLength = 1;
+
+	for (; *link != nullptr; link = &(*link)->next, chainLength++) {
+		if ((*link)->hashMatches(hash) && keyEqual_((*link)->entry.key, key))
+			return link;
 	}
+	return link;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::linkNode_(Node **link, Node *n, unsigned chainLength, bool inOldTable) {
 	// insert entry into table
-	chosenList.push_back(e);
+	*link = n;
 	
 	// clean up table if needed
-	if (longestChainLength_ < chosenList.size())
-		longestChainLength_ = chosenList.size();
+	// chains left in the old table are about to be migrated, so they dont count
+	if (longestChainLength_ < chainLength && !inOldTable)
+		longestChainLength_ = chainLength;
 	
 	entryCount_++;
 
-	// resize table if a chain gets too long
+	// resize table if a chain gets too long, nodes are relinked so n stays valid
+	// while migrating this only updates the waiting resize, so inserts never finish a migration all at once
 	if (longestChainLength_ > LONGEST_ACCEPTABLE_CHAIN_LENGTH)	
 		resize();
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K, typename... Args>
+inline std::pair<DataT *, bool> ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::tryEmplaceHashed_(K &&key, std::size_t hash, Args&&... args) {
+	step_();
+
+	unsigned chainLength;
+	bool inOldTable;
+	Node **link = findLink_(key, hash, chainLength, inOldTable);
+
+	// ensure key doesnt exist in table
+	if (*link != nullptr)
+		return std::make_pair(&(*link)->entry.data, false);
+
+	Node *n = new (pool_.allocate()) Node(hash, std::piecewise_construct, std::forward<K>(key), std::forward<Args>(args)...);
+	linkNode_(link, n, chainLength, inOldTable);
+	return std::make_pair(&n->entry.data, true);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insert(const Entry &e) {
+	return tryEmplaceHashed_(e.key, hasher_(e.key), e.data).second;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insert(Entry &&e) {
+	std::size_t hash = hasher_(e.key);
+	return tryEmplaceHashed_(std::move(e.key), hash, std::move(e.data)).second;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insert(const KeyT &key, const DataT &data) {
+	return tryEmplaceHashed_(key, hasher_(key), data).second;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insert(KeyT &&key, DataT &&data) {
+	std::size_t hash = hasher_(key);
+	return tryEmplaceHashed_(std::move(key), hash, std::move(data)).second;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename... Args>
+inline std::pair<DataT *, bool> ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::emplace(Args&&... args) {
+	step_();
+
+	Node *n = new (pool_.allocate()) Node(0, std::forward<Args>(args)...);
+	std::size_t hash = hasher_(n->entry.key);
+	n->setHash(hash);
+
+	unsigned chainLength;
+	bool inOldTable;
+	Node **link = findLink_(n->entry.key, hash, chainLength, inOldTable);
+
+	if (*link != nullptr) {
+		n->~Node();
+		pool_.deallocate(n);
+		return std::make_pair(&(*link)->entry.data, false);
+	}
+
+	linkNode_(link, n, chainLength, inOldTable);
+	return std::make_pair(&n->entry.data, true);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename... Args>
+inline std::pair<DataT *, bool> ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::tryEmplace(const KeyT &key, Args&&... args) {
+	return tryEmplaceHashed_(key, hasher_(key), std::forward<Args>(args)...);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename... Args>
+inline std::pair<DataT *, bool> ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::tryEmplace(KeyT &&key, Args&&... args) {
+	std::size_t hash = hasher_(key);
+	return tryEmplaceHashed_(std::move(key), hash, std::forward<Args>(args)...);
+}
 
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename D>
+inline std::pair<DataT *, bool> ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insertOrAssign(const KeyT &key, D &&data) {
+	std::pair<DataT *, bool> result = tryEmplaceHashed_(key, hasher_(key), std::forward<D>(data));
+	if (!result.second)
+		*result.first = std::forward<D>(data);
+	return result;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename D>
+inline std::pair<DataT *, bool> ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insertOrAssign(KeyT &&key, D &&data) {
+	std::size_t hash = hasher_(key);
+	std::pair<DataT *, bool> result = tryEmplaceHashed_(std::move(key), hash, std::forward<D>(data));
+	if (!result.second)
+		*result.first = std::forward<D>(data);
+	return result;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::remove_(const K &key) {
+	step_();
+
+	unsigned chainLength;
+	bool inOldTable;
+	Node **link = findLink_(key, hasher_(key), chainLength, inOldTable);
+
+	Node *n = *link;
+	if (n == nullptr)
+		return false;
+
+	*link = n->next;
+	n->~Node();
+	pool_.deallocate(n);
+	--entryCount_;
 	return true;
 }
 
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::remove(const KeyT &key) {
+	return remove_(key);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K, typename H, typename>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::remove(const K &key) {
+	return remove_(key);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K>
+inline DataT * ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::find_(const K &key) const {
+	migrate_(migrationStep_);
+
+	std::size_t hash = hasher_(key);
+	Node *n = findInChain_(chainOf_(hash), key, hash);
+
+	return (n == nullptr) ? nullptr : &n->entry.data;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline DataT * ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::find(const KeyT &key) const {
+	return find_(key);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K, typename H, typename>
+inline DataT * ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::find(const K &key) const {
+	return find_(key);
+}
 
-template<typename KeyT, typename DataT>
-inline bool ChainedHashMap<KeyT, DataT>::insert(const KeyT key, const DataT data) {
-	return insert(Entry(key, data));
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename K>
+inline typename ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Node * 
+ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::findInChain_(Node *chain, const K &key, std::size_t hash) const {
+	for (Node *n = chain; n != nullptr; n = n->next) {
+		if (n->hashMatches(hash) && keyEqual_(n->entry.key, key)) 
+			return n;
+	}
+	return nullptr;
 }
 
 
-template<typename KeyT, typename DataT>
-inline bool ChainedHashMap<KeyT, DataT>::remove(KeyT key) {
-	std::list<Entry> &chosenList = table_[hasher_(key) % tableSize_];
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+unsigned ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insertBatch(const Entry *entries, std::size_t n, bool *inserted) {
+	// same pipeline as findBatch, but an insert may resize the table, 
+	// so chains are looked up again at every stage instead of being kept
+	const std::size_t ring = 4 * HASHMAP_BATCH_SIZE;
+	std::size_t hashes[ring];
+	unsigned insertCount = 0;
+
+	for (std::size_t i = 0; i < n + 2 * HASHMAP_BATCH_SIZE; i++) {
+		if (i < n) {
+			hashes[i % ring] = hasher_(entries[i].key);
+			HASHMAP_PREFETCH(&chainOf_(hashes[i % ring]));
+		}
+
+		std::size_t j = i - HASHMAP_BATCH_SIZE;
+		if (i >= HASHMAP_BATCH_SIZE && j < n)
+			HASHMAP_PREFETCH(chainOf_(hashes[j % ring]));
 
-	for (auto it = chosenList.begin(); it != chosenList.end(); ++it) {
-		if ((*it).key == key) {
-			chosenList.erase(it);
-			--entryCount_;
-			return true;
+		std::size_t k = i - 2 * HASHMAP_BATCH_SIZE;
+		if (i >= 2 * HASHMAP_BATCH_SIZE && k < n) {
+			bool wasInserted = tryEmplaceHashed_(entries[k].key, hashes[k % ring], entries[k].data).second;
+			insertCount += wasInserted;
+			if (inserted != nullptr)
+				inserted[k] = wasInserted;
 		}
 	}
-	return false;
+	return insertCount;
 }
 
 
-template<typename KeyT, typename DataT>
-inline DataT * ChainedHashMap<KeyT, DataT>::find(KeyT key) const {
-	std::list<Entry> &chosenList = table_[hasher_(key) % tableSize_];
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+unsigned ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::findBatch(const KeyT *keys, std::size_t n, DataT **out) const {
+	// each key is hashed and its bucket prefetched, HASHMAP_BATCH_SIZE keys later its first node is prefetched,
+	// then another HASHMAP_BATCH_SIZE keys later it is resolved
+	// the last 2 * HASHMAP_BATCH_SIZE keys' chains are kept in a ring, sized to a power of 2 above that
+	const std::size_t ring = 4 * HASHMAP_BATCH_SIZE;
+	std::size_t hashes[ring];
+	Node **chains[ring];
+	unsigned foundCount = 0;
+
+	// does all the migration the batch's n finds would have up front, so no chain moves while its key is in flight
+	if (migrating()) {
+		std::size_t buckets = (n < oldTableSize_) ? (std::size_t)migrationStep_ * n : oldTableSize_;
+		migrate_((buckets < oldTableSize_) ? (unsigned)buckets : oldTableSize_);
+	}
+
+	for (std::size_t i = 0; i < n + 2 * HASHMAP_BATCH_SIZE; i++) {
+		if (i < n) {
+			hashes[i % ring] = hasher_(keys[i]);
+			chains[i % ring] = &chainOf_(hashes[i % ring]);
+			HASHMAP_PREFETCH(chains[i % ring]);
+		}
+
+		std::size_t j = i - HASHMAP_BATCH_SIZE;
+		if (i >= HASHMAP_BATCH_SIZE && j < n)
+			HASHMAP_PREFETCH(*chains[j % ring]);
 
-	for (auto it = chosenList.begin(); it != chosenList.end(); ++it) {
-		if ((*it).key == key) 
-			return &(*it).data;
+		std::size_t k = i - 2 * HASHMAP_BATCH_SIZE;
+		if (i >= 2 * HASHMAP_BATCH_SIZE && k < n) {
+			Node *found = findInChain_(*chains[k % ring], keys[k], hashes[k % ring]);
+			out[k] = (found == nullptr) ? nullptr : &found->entry.data;
+			foundCount += (found != nullptr);
+		}
 	}
-	return nullptr;
+	return foundCount;
 }
 
 
-template<typename KeyT, typename DataT>
-inline unsigned ChainedHashMap<KeyT, DataT>::entries() const { 
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename FuncT>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::forEach(FuncT fn) const {
+	for (unsigned i = 0; i < tableSize_; i++) {
+		for (const Node *n = table_[i]; n != nullptr; n = n->next)
+			fn(n->entry);
+	}
+	for (unsigned i = migratedBuckets_; oldTable_ != nullptr && i < oldTableSize_; i++) {
+		for (const Node *n = oldTable_[i]; n != nullptr; n = n->next)
+			fn(n->entry);
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::entries() const { 
 	return entryCount_; 
 }
 
-template<typename KeyT, typename DataT>
-inline unsigned ChainedHashMap<KeyT, DataT>::longestChain() const {
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::longestChain() const {
 	return longestChainLength_;
 }
 
-template<typename KeyT, typename DataT>
-inline unsigned ChainedHashMap<KeyT, DataT>::tableSize() const {
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::tableSize() const {
 	return tableSize_;
 }
 
-template<typename KeyT, typename DataT>
-inline void ChainedHashMap<KeyT, DataT>::resizeForce_(unsigned int newTableSize) {
-	std::list<Entry> *newTable = new std::list<Entry>[newTableSize];
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline typename ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Node *& ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::chainOf_(std::size_t hash, bool *inOldTable) const {
+	bool old = oldTable_ != nullptr && hash % oldTableSize_ >= migratedBuckets_;
 
-	for (unsigned i = 0; i < tableSize_; i++) {
-		std::list<Entry> &originList = table_[i];
-		for (auto it = originList.begin(); it != originList.end(); ++it)
-			newTable[hasher_((*it).key) % newTableSize].push_back((*it));
+	if (inOldTable != nullptr)
+		*inOldTable = old;
+	return old ? oldTable_[hash % oldTableSize_] : table_[hash % tableSize_];
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::migrate_(unsigned buckets) const {
+	if (oldTable_ == nullptr)
+		return;
+
+	for (; buckets > 0 && migratedBuckets_ < oldTableSize_; buckets--, migratedBuckets_++) {
+		relinkChain_(oldTable_[migratedBuckets_]);
+		oldTable_[migratedBuckets_] = nullptr;
 	}
 
-	longestChainLength_ = 1;
-	delete[] table_;
-	table_ = newTable;
+	if (migratedBuckets_ == oldTableSize_) {
+		delete[] oldTable_;
+		oldTable_ = nullptr;
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::step_() {
+	migrate_(migrationStep_);
+
+	if (pendingTableSize_ != 0 && !migrating()) {
+		unsigned size = pendingTableSize_;
+		pendingTableSize_ = 0;
+		resizeForce_(size);
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::relinkChain_(Node *chain) const {
+	while (chain != nullptr) {
+		Node *n = chain;
+		chain = chain->next;
+
+		Node *&chosenChain = table_[n->hashOf(hasher_, n->entry.key) % tableSize_];
+		n->next = chosenChain;
+		chosenChain = n;
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::incrementalResize(bool enabled) {
+	incremental_ = enabled;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::incrementalResize() const {
+	return incremental_;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::migrationStep(unsigned buckets) {
+	migrationStep_ = (buckets == 0) ? 1 : buckets;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::migrationStep() const {
+	return migrationStep_;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::migrating() const {
+	return oldTable_ != nullptr;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline float ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::migrationProgress() const {
+	return migrating() ? (float)migratedBuckets_ / oldTableSize_ : 1.0f;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::finishMigration() {
+	// a waiting resize starts another migration, which is finished too
+	while (migrating()) {
+		migrate_(oldTableSize_);
+		step_();
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::resizeForce_(unsigned int newTableSize) {
+	// only one old table can be kept around at a time, so the resize waits for the current migration
+	if (migrating()) {
+		if (incremental_) {
+			pendingTableSize_ = newTableSize;
+			return;
+		}
+		pendingTableSize_ = 0;
+		finishMigration();
+	}
+
+	if (incremental_) {
+		oldTable_ = table_;
+		oldTableSize_ = tableSize_;
+		migratedBuckets_ = 0;
+
+		table_ = new Node*[newTableSize]();
+		tableSize_ = newTableSize;
+		longestChainLength_ = 0;
+		return;
+	}
+
+	Node **oldTable = table_;
+	unsigned oldTableSize = tableSize_;
+
+	table_ = new Node*[newTableSize]();
 	tableSize_ = newTableSize;
+
+	for (unsigned i = 0; i < oldTableSize; i++)
+		relinkChain_(oldTable[i]);
+
+	longestChainLength_ = 1;
+	delete[] oldTable;
 }
 
 
-template<typename KeyT, typename DataT>
-inline void ChainedHashMap<KeyT, DataT>::resize() {
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::resize() {
 	resizeForce_(entryCount_ * (unsigned)GROWTH_RATE);
 }
 
 
-template<typename KeyT, typename DataT>
-inline bool ChainedHashMap<KeyT, DataT>::resize(unsigned newTableSize) {
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::resize(unsigned newTableSize) {
 	if (entryCount_ / newTableSize <= LONGEST_ACCEPTABLE_CHAIN_LENGTH) {
 		resizeForce_(newTableSize);
 		return true;
@@ -0,0 +1,329 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include "chainedhashmap.h"
+
+// A chained hashmap that can be shared between threads
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// the table is guarded by a fixed number of reader/writer locks, each covering every
+// CONCURRENT_HASHMAP_STRIPES'th bucket. the table size is always a multiple of the stripe count,
+// so a key's stripe only depends on its hash and never changes when the table is resized.
+// lookups only take their stripe's lock shared, inserts and removes take it exclusively,
+// and only resizing takes every stripe at once.
+
+#define CONCURRENT_HASHMAP_STRIPES 64 // number of locks guarding the table
+
+template<typename KeyT, typename DataT,
+	typename HashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>, bool StoreHash = !std::is_arithmetic<KeyT>::value>
+class ConcurrentHashMap {
+public:
+	// element in hashmap
+	struct Entry {
+		KeyT key;
+		DataT data;
+		Entry(KeyT key, DataT data) : key(key), data(data) {}
+	};
+
+public:
+	// creates a hashmap
+	// size is the starting width of the hashmap, rounded up to a multiple of CONCURRENT_HASHMAP_STRIPES,
+	// will grow if the hashmap gets a chain longer than LONGEST_ACCEPTABLE_CHAIN_LENGTH
+	ConcurrentHashMap(unsigned size = HASHMAP_BASIC_SIZE, const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	// creates a hashmap with the given hasher
+	ConcurrentHashMap(const HashT &hasher, unsigned size = HASHMAP_BASIC_SIZE);
+
+	ConcurrentHashMap(const ConcurrentHashMap &map) = delete;
+	ConcurrentHashMap & operator=(const ConcurrentHashMap &map) = delete;
+
+	~ConcurrentHashMap();
+
+	// insert an entry into hashmap
+	// if the hashmap has become overpopulated, will resize to increase searching efficency
+	// true if inserted, false if key already exists
+	bool insert(const Entry &e);
+	// insert element into hashmap by key and its data
+	bool insert(const KeyT key, const DataT data);
+
+	// remove a key from hashmap
+	// true if removed, false if not found
+	bool remove(const KeyT &key);
+
+	// search for the data associated with the given key
+	// another thread may remove the entry at any moment, so the data is copied into out instead of pointed to
+	// true if found
+	bool find(const KeyT &key, DataT &out) const;
+
+	// true if key is in hashmap
+	bool contains(const KeyT &key) const;
+
+	// calls fn(DataT &) on the data associated with the given key, while holding its stripe exclusively
+	// true if found
+	template<typename FuncT>
+	bool update(const KeyT &key, FuncT fn);
+
+	// number of entries hashmap is storing
+	unsigned entries() const;
+
+	// size of internal table
+	unsigned tableSize() const;
+
+	// resizes the hashmap to hold entries() * GROWTH_RATE in its first layer
+	void resize();
+
+	// resizes to given size, rounded up to a multiple of CONCURRENT_HASHMAP_STRIPES, unless it is too small to hold all entries
+	// while keeping chains below LONGEST_ACCEPTABLE_CHAIN_LENGTH
+	// returns true if resized, otherwise false
+	bool resize(unsigned newTableSize);
+
+protected:
+	// link in a chain
+	struct Node : ChainedHashCode<StoreHash> {
+		Entry entry;
+		Node *next;
+		Node(const Entry &entry, std::size_t hash) : ChainedHashCode<StoreHash>(hash), entry(entry), next(nullptr) {}
+	};
+
+	// a lock and the nodes of every bucket it guards, kept on separate cache lines
+	// so threads working on different stripes dont contend
+	struct alignas(64) Stripe {
+		mutable std::shared_mutex lock;
+		NodePool<Node> pool;
+	};
+
+protected:
+	// hashmap body, first node of each chain
+	// only changed while every stripe is held, reading it under any one stripe is safe
+	Node **table_;
+	unsigned tableSize_;
+
+	Stripe stripes_[CONCURRENT_HASHMAP_STRIPES];
+
+	// hashing function, must convert key to a std::size_t
+	HashT hasher_;
+
+	// true if two keys are the same
+	KeyEqualT keyEqual_;
+
+	// number of elements hashmap is storing
+	std::atomic<unsigned> entryCount_;
+
+protected:
+	// smallest multiple of CONCURRENT_HASHMAP_STRIPES that is at least size
+	static unsigned roundUpTableSize_(unsigned size);
+
+	// stripe guarding a hash's bucket
+	Stripe & stripeOf_(std::size_t hash) { return stripes_[hash % CONCURRENT_HASHMAP_STRIPES]; }
+	const Stripe & stripeOf_(std::size_t hash) const { return stripes_[hash % CONCURRENT_HASHMAP_STRIPES]; }
+
+	// node holding key in its chain, nullptr if not found, the key's stripe must be held
+	Node * findNode_(const KeyT &key, std::size_t hash) const;
+
+	// resizes to newTableSize unless the table is no longer expectedTableSize, meaning another thread got there first
+	// the new table is allocated before any stripe is taken, all stripes are held only while nodes are relinked
+	// returns true if resized
+	bool resizeFrom_(unsigned expectedTableSize, unsigned newTableSize);
+};
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::ConcurrentHashMap(unsigned size, const HashT &hasher, const KeyEqualT &keyEqual)
+	: tableSize_(roundUpTableSize_(size)), hasher_(hasher), keyEqual_(keyEqual), entryCount_(0)
+{
+	table_ = new Node*[tableSize_]();
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::ConcurrentHashMap(const HashT &hasher, unsigned size)
+	: ConcurrentHashMap(size, hasher)
+{}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::~ConcurrentHashMap() {
+	// nodes are released along with the pools, only their entries may need destroying
+	if (!std::is_trivially_destructible<Entry>::value) {
+		for (unsigned i = 0; i < tableSize_; i++) {
+			for (Node *n = table_[i]; n != nullptr; n = n->next)
+				n->entry.~Entry();
+		}
+	}
+	delete[] table_;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::roundUpTableSize_(unsigned size) {
+	if (size < CONCURRENT_HASHMAP_STRIPES)
+		return CONCURRENT_HASHMAP_STRIPES;
+	return (size + CONCURRENT_HASHMAP_STRIPES - 1) / CONCURRENT_HASHMAP_STRIPES * CONCURRENT_HASHMAP_STRIPES;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline typename ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Node *
+ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::findNode_(const KeyT &key, std::size_t hash) const {
+	for (Node *n = table_[hash % tableSize_]; n != nullptr; n = n->next) {
+		if (n->hashMatches(hash) && keyEqual_(n->entry.key, key))
+			return n;
+	}
+	return nullptr;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insert(const Entry &e) {
+	std::size_t hash = hasher_(e.key);
+	Stripe &stripe = stripeOf_(hash);
+	unsigned chainLength = 1, observedTableSize;
+
+	{
+		std::unique_lock<std::shared_mutex> lock(stripe.lock);
+
+		Node **link = &table_[hash % tableSize_];
+		// ensure key doesnt exist in table
+		for (; *link != nullptr; link = &(*link)->next, chainLength++) {
+			if ((*link)->hashMatches(hash) && keyEqual_((*link)->entry.key, e.key))
+				return false;
+		}
+		// insert entry into table
+		*link = new (stripe.pool.allocate()) Node(e, hash);
+		observedTableSize = tableSize_;
+	}
+
+	entryCount_++;
+
+	// resize table if a chain gets too long, unless another thread already did
+	// or the chain is long only because of colliding hashes, and a larger table wouldnt help
+	unsigned newTableSize = entryCount_ * (unsigned)GROWTH_RATE;
+	if (chainLength > LONGEST_ACCEPTABLE_CHAIN_LENGTH && roundUpTableSize_(newTableSize) > observedTableSize)
+		resizeFrom_(observedTableSize, newTableSize);
+
+	return true;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::insert(const KeyT key, const DataT data) {
+	return insert(Entry(key, data));
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::remove(const KeyT &key) {
+	std::size_t hash = hasher_(key);
+	Stripe &stripe = stripeOf_(hash);
+	std::unique_lock<std::shared_mutex> lock(stripe.lock);
+
+	for (Node **link = &table_[hash % tableSize_]; *link != nullptr; link = &(*link)->next) {
+		Node *n = *link;
+		if (n->hashMatches(hash) && keyEqual_(n->entry.key, key)) {
+			*link = n->next;
+			n->~Node();
+			stripe.pool.deallocate(n);
+			--entryCount_;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::find(const KeyT &key, DataT &out) const {
+	std::size_t hash = hasher_(key);
+	std::shared_lock<std::shared_mutex> lock(stripeOf_(hash).lock);
+
+	Node *n = findNode_(key, hash);
+	if (n != nullptr)
+		out = n->entry.data;
+	return n != nullptr;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::contains(const KeyT &key) const {
+	std::size_t hash = hasher_(key);
+	std::shared_lock<std::shared_mutex> lock(stripeOf_(hash).lock);
+
+	return findNode_(key, hash) != nullptr;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+template<typename FuncT>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::update(const KeyT &key, FuncT fn) {
+	std::size_t hash = hasher_(key);
+	std::unique_lock<std::shared_mutex> lock(stripeOf_(hash).lock);
+
+	Node *n = findNode_(key, hash);
+	if (n != nullptr)
+		fn(n->entry.data);
+	return n != nullptr;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::entries() const {
+	return entryCount_;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline unsigned ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::tableSize() const {
+	std::shared_lock<std::shared_mutex> lock(stripes_[0].lock);
+	return tableSize_;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::resizeFrom_(unsigned expectedTableSize, unsigned newTableSize) {
+	newTableSize = roundUpTableSize_(newTableSize);
+	Node **newTable = new Node*[newTableSize]();
+	Node **oldTable = newTable;
+
+	// stripes are always taken in the same order, and no other operation holds more than one
+	for (unsigned i = 0; i < CONCURRENT_HASHMAP_STRIPES; i++)
+		stripes_[i].lock.lock();
+
+	if (tableSize_ == expectedTableSize) {
+		// a key's stripe doesnt depend on the table size, so nodes never leave the pool they came from
+		for (unsigned i = 0; i < tableSize_; i++) {
+			Node *chain = table_[i];
+			while (chain != nullptr) {
+				Node *n = chain;
+				chain = chain->next;
+
+				Node *&chosenChain = newTable[n->hashOf(hasher_, n->entry.key) % newTableSize];
+				n->next = chosenChain;
+				chosenChain = n;
+			}
+		}
+
+		oldTable = table_;
+		table_ = newTable;
+		tableSize_ = newTableSize;
+	}
+
+	for (unsigned i = CONCURRENT_HASHMAP_STRIPES; i > 0; i--)
+		stripes_[i - 1].lock.unlock();
+
+	// frees whichever table is no longer used
+	delete[] oldTable;
+	return oldTable != newTable;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline void ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::resize() {
+	resizeFrom_(tableSize(), entryCount_ * (unsigned)GROWTH_RATE);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline bool ConcurrentHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::resize(unsigned newTableSize) {
+	if (entryCount_ / roundUpTableSize_(newTableSize) <= LONGEST_ACCEPTABLE_CHAIN_LENGTH)
+		return resizeFrom_(tableSize(), newTableSize);
+	return false;
+}
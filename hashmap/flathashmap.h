@@ -0,0 +1,514 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+
+// An open addressing hashmap, probed one group of control bytes at a time
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// every slot in the table has a control byte, which is either EMPTY, DELETED (a tombstone),
+// or holds the low 7 bits of the slot's hash when it is full.
+// lookups compare a whole group of control bytes against the key's 7 bit tag at once,
+// and only compare keys for slots whose tag matched, so most misses never touch an entry.
+// entries are stored inline in one array, no per-entry allocations are made.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_HASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define FLAT_HASHMAP_BASIC_SIZE 64 // default starting size for hashmap, always rounded up to a power of 2
+#define FLAT_HASHMAP_GROUP_WIDTH 16 // number of control bytes scanned at once
+#define FLAT_HASHMAP_MAX_LOAD_FACTOR 7/8 // table will re-size once entries + tombstones exceed tableSize * FLAT_HASHMAP_MAX_LOAD_FACTOR
+
+// HashT and KeyEqualT are function objects hashing a key into a std::size_t and comparing two keys,
+// the same as ChainedHashMap's so either map can be swapped for the other
+template<typename KeyT, typename DataT, typename HashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>>
+class FlatHashMap {
+public:
+	// element in hashmap
+	struct Entry {
+		KeyT key;
+		DataT data;
+		Entry(KeyT key, DataT data) : key(key), data(data) {}
+	};
+
+public:
+	// creates a hashmap
+	//
+	// the hash is mixed before use, so hashers that only spread keys over the low bits
+	// (such as returning an integer key as is) are fine
+	//
+	// size is the starting width of the hashmap, rounded up to a power of 2,
+	// will grow once the table passes FLAT_HASHMAP_MAX_LOAD_FACTOR
+	FlatHashMap(unsigned size = FLAT_HASHMAP_BASIC_SIZE, const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	// creates a hashmap with the given hasher
+	FlatHashMap(const HashT &hasher, unsigned size = FLAT_HASHMAP_BASIC_SIZE);
+
+	// copy an existing hashmap
+	FlatHashMap(const FlatHashMap &map);
+
+	FlatHashMap & operator=(const FlatHashMap &map) = delete;
+
+	~FlatHashMap();
+
+	// insert an entry into hashmap
+	// if the hashmap has become overpopulated, will resize to keep probe sequences short
+	// true if inserted, false if key already exists
+	bool insert(const Entry &e);
+	// insert element into hashmap by key and its data
+	bool insert(const KeyT key, const DataT data);
+
+	// remove a key from hashmap
+	// leaves a tombstone behind unless no probe sequence could have passed over the slot
+	// true if removed, false if not found
+	bool remove(KeyT key);
+
+	// search for the data associated with the given key
+	// returns pointer to key's associated data if found, if not found, returns nullptr
+	DataT * find(KeyT key) const;
+
+	// number of entries hashmap is storing
+	unsigned entries() const;
+
+	// number of removed slots still occupying the table
+	unsigned tombstones() const;
+
+	// size of internal table
+	unsigned tableSize() const;
+
+	// rehashes into the smallest table that can hold entries() without passing the max load factor,
+	// also clears out all tombstones
+	void resize();
+
+	// resizes to given size, rounded up to a power of 2, unless it is too small to hold all entries
+	// without passing the max load factor
+	// returns true if resized, otherwise false
+	bool resize(unsigned newTableSize);
+
+protected:
+	// control byte values, a full slot holds the low 7 bits of its hash instead
+	static const int8_t EMPTY_ = -128;
+	static const int8_t DELETED_ = -2;
+
+	// FLAT_HASHMAP_GROUP_WIDTH control bytes, matched all at once
+	class Group_;
+
+protected:
+	// one control byte per slot, followed by a copy of the first FLAT_HASHMAP_GROUP_WIDTH - 1 bytes
+	// so that a group can be loaded starting at any slot
+	int8_t *ctrl_;
+
+	// hashmap body, only slots with a full control byte hold a constructed entry
+	Entry *slots_;
+
+	// always a power of 2
+	unsigned tableSize_;
+
+	// hashing function, must convert key to a std::size_t
+	HashT hasher_;
+
+	// true if two keys are the same
+	KeyEqualT keyEqual_;
+
+	// number of elements hashmap is storing
+	unsigned entryCount_;
+
+	// number of DELETED slots
+	unsigned tombstoneCount_;
+
+	// how many EMPTY slots can still be filled before the table must re-size
+	unsigned growthLeft_;
+
+protected:
+	// spreads the user's hash over all 32 bits used
+	static unsigned mix_(std::size_t h);
+
+	// most entries a table of the given size may hold
+	static unsigned maxLoad_(unsigned tableSize) { return tableSize * FLAT_HASHMAP_MAX_LOAD_FACTOR; }
+
+	// smallest power of 2 table that is at least size
+	static unsigned roundUpTableSize_(unsigned size);
+
+	static unsigned lowestBit_(unsigned mask);
+	static unsigned highestBit_(unsigned mask);
+
+	// sets a slot's control byte, and its mirror past the end of the table
+	void setCtrl_(unsigned i, int8_t h);
+
+	// first EMPTY or DELETED slot on the probe sequence of hash
+	unsigned findFirstNonFull_(unsigned hash) const;
+
+	// slot holding key, or tableSize_ if not found
+	unsigned findSlot_(const KeyT &key, unsigned hash) const;
+
+	// called when an insert is about to fill the last EMPTY slot it may,
+	// either clears out tombstones or grows the table
+	void rehashAndGrow_();
+
+	// moves every entry into a new table of the given size, which must be a power of 2
+	void resizeForce_(unsigned newTableSize);
+
+	// allocates empty ctrl_ and slots_ for a table of the given size
+	void allocate_(unsigned tableSize);
+
+	// destroys every entry and frees the table
+	void destroy_();
+};
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+class FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::Group_ {
+public:
+#ifdef FLAT_HASHMAP_SSE2
+	explicit Group_(const int8_t *pos)
+		: ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos)))
+	{}
+
+	// bit i is set if control byte i equals h
+	unsigned match(int8_t h) const {
+		return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h), ctrl_));
+	}
+
+	// bit i is set if control byte i is EMPTY or DELETED, these are the only ones with their high bit set
+	unsigned matchNonFull() const {
+		return (unsigned)_mm_movemask_epi8(ctrl_);
+	}
+
+protected:
+	__m128i ctrl_;
+#else
+	explicit Group_(const int8_t *pos) {
+		std::memcpy(ctrl_, pos, FLAT_HASHMAP_GROUP_WIDTH);
+	}
+
+	unsigned match(int8_t h) const {
+		unsigned mask = 0;
+		for (unsigned i = 0; i < FLAT_HASHMAP_GROUP_WIDTH; i++)
+			mask |= (unsigned)(ctrl_[i] == h) << i;
+		return mask;
+	}
+
+	unsigned matchNonFull() const {
+		unsigned mask = 0;
+		for (unsigned i = 0; i < FLAT_HASHMAP_GROUP_WIDTH; i++)
+			mask |= (unsigned)(ctrl_[i] < 0) << i;
+		return mask;
+	}
+
+protected:
+	int8_t ctrl_[FLAT_HASHMAP_GROUP_WIDTH];
+#endif
+
+public:
+	unsigned matchEmpty() const { return match(EMPTY_); }
+};
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::FlatHashMap(unsigned size, const HashT &hasher, const KeyEqualT &keyEqual)
+	: hasher_(hasher), keyEqual_(keyEqual), entryCount_(0), tombstoneCount_(0)
+{
+	allocate_(roundUpTableSize_(size));
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::FlatHashMap(const HashT &hasher, unsigned size)
+	: FlatHashMap(size, hasher)
+{}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::FlatHashMap(const FlatHashMap &map)
+	: hasher_(map.hasher_), keyEqual_(map.keyEqual_), entryCount_(map.entryCount_), tombstoneCount_(map.tombstoneCount_)
+{
+	allocate_(map.tableSize_);
+	growthLeft_ = map.growthLeft_;
+
+	// same table size means every entry can stay in the same slot, no rehashing needed
+	std::memcpy(ctrl_, map.ctrl_, tableSize_ + FLAT_HASHMAP_GROUP_WIDTH - 1);
+	for (unsigned i = 0; i < tableSize_; i++) {
+		if (ctrl_[i] >= 0)
+			new (slots_ + i) Entry(map.slots_[i]);
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::~FlatHashMap() {
+	destroy_();
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::mix_(std::size_t hash) {
+	// folds in the high half of 64 bit hashes, shifted twice so 32 bit size_t is fine too
+	unsigned h = (unsigned)(hash ^ (hash >> 16 >> 16));
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::roundUpTableSize_(unsigned size) {
+	unsigned tableSize = FLAT_HASHMAP_GROUP_WIDTH;
+	while (tableSize < size)
+		tableSize <<= 1;
+	return tableSize;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::lowestBit_(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+	unsigned long i;
+	_BitScanForward(&i, mask);
+	return (unsigned)i;
+#else
+	unsigned i = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::highestBit_(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	return 31u - (unsigned)__builtin_clz(mask);
+#elif defined(_MSC_VER)
+	unsigned long i;
+	_BitScanReverse(&i, mask);
+	return (unsigned)i;
+#else
+	unsigned i = 0;
+	while (mask >>= 1)
+		i++;
+	return i;
+#endif
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::setCtrl_(unsigned i, int8_t h) {
+	ctrl_[i] = h;
+	// slots below FLAT_HASHMAP_GROUP_WIDTH - 1 are mirrored past the end, the rest just write themselves again
+	ctrl_[((i - (FLAT_HASHMAP_GROUP_WIDTH - 1)) & (tableSize_ - 1)) + (FLAT_HASHMAP_GROUP_WIDTH - 1)] = h;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::findFirstNonFull_(unsigned hash) const {
+	const unsigned mask = tableSize_ - 1;
+	unsigned pos = (hash >> 7) & mask;
+
+	for (unsigned step = FLAT_HASHMAP_GROUP_WIDTH; ; step += FLAT_HASHMAP_GROUP_WIDTH) {
+		unsigned nonFull = Group_(ctrl_ + pos).matchNonFull();
+		if (nonFull)
+			return (pos + lowestBit_(nonFull)) & mask;
+		pos = (pos + step) & mask;
+	}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::findSlot_(const KeyT &key, unsigned hash) const {
+	const unsigned mask = tableSize_ - 1;
+	const int8_t tag = (int8_t)(hash & 0x7F);
+	unsigned pos = (hash >> 7) & mask;
+
+	// probes whole groups, stepping 1, 2, 3... groups further each time,
+	// which visits every group since the table size is a power of 2
+	for (unsigned step = FLAT_HASHMAP_GROUP_WIDTH; ; step += FLAT_HASHMAP_GROUP_WIDTH) {
+		Group_ group(ctrl_ + pos);
+
+		for (unsigned m = group.match(tag); m != 0; m &= m - 1) {
+			unsigned i = (pos + lowestBit_(m)) & mask;
+			if (keyEqual_(slots_[i].key, key))
+				return i;
+		}
+		// key would have been placed in this group's empty slot if it existed
+		if (group.matchEmpty())
+			return tableSize_;
+
+		pos = (pos + step) & mask;
+	}
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline bool FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::insert(const Entry &e) {
+	unsigned hash = mix_(hasher_(e.key));
+
+	// ensure key doesnt exist in table
+	if (findSlot_(e.key, hash) != tableSize_)
+		return false;
+
+	unsigned i = findFirstNonFull_(hash);
+
+	// reusing a tombstone doesnt make any probe sequence longer, only filling an empty slot needs room to grow
+	if (growthLeft_ == 0 && ctrl_[i] == EMPTY_) {
+		rehashAndGrow_();
+		i = findFirstNonFull_(hash);
+	}
+
+	if (ctrl_[i] == EMPTY_)
+		growthLeft_--;
+	else
+		tombstoneCount_--;
+
+	new (slots_ + i) Entry(e);
+	setCtrl_(i, (int8_t)(hash & 0x7F));
+	entryCount_++;
+
+	return true;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline bool FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::insert(const KeyT key, const DataT data) {
+	return insert(Entry(key, data));
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline bool FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::remove(KeyT key) {
+	unsigned i = findSlot_(key, mix_(hasher_(key)));
+	if (i == tableSize_)
+		return false;
+
+	slots_[i].~Entry();
+	--entryCount_;
+
+	// if every group that could contain this slot also has an empty slot,
+	// no probe sequence ever had to step over it, so it can go straight back to EMPTY
+	const unsigned mask = tableSize_ - 1;
+	unsigned emptyBefore = Group_(ctrl_ + ((i - FLAT_HASHMAP_GROUP_WIDTH) & mask)).matchEmpty();
+	unsigned emptyAfter = Group_(ctrl_ + i).matchEmpty();
+
+	bool wasNeverFull = emptyBefore && emptyAfter &&
+		lowestBit_(emptyAfter) + (FLAT_HASHMAP_GROUP_WIDTH - 1 - highestBit_(emptyBefore)) < FLAT_HASHMAP_GROUP_WIDTH;
+
+	if (wasNeverFull) {
+		setCtrl_(i, EMPTY_);
+		growthLeft_++;
+	}
+	else {
+		setCtrl_(i, DELETED_);
+		tombstoneCount_++;
+	}
+	return true;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline DataT * FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::find(KeyT key) const {
+	unsigned i = findSlot_(key, mix_(hasher_(key)));
+	return (i == tableSize_) ? nullptr : &slots_[i].data;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::entries() const {
+	return entryCount_;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::tombstones() const {
+	return tombstoneCount_;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::tableSize() const {
+	return tableSize_;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::allocate_(unsigned tableSize) {
+	tableSize_ = tableSize;
+	ctrl_ = new int8_t[tableSize + FLAT_HASHMAP_GROUP_WIDTH - 1];
+	std::memset(ctrl_, EMPTY_, tableSize + FLAT_HASHMAP_GROUP_WIDTH - 1);
+	slots_ = static_cast<Entry *>(::operator new(sizeof(Entry) * tableSize));
+	growthLeft_ = maxLoad_(tableSize);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::destroy_() {
+	for (unsigned i = 0; i < tableSize_; i++) {
+		if (ctrl_[i] >= 0)
+			slots_[i].~Entry();
+	}
+	delete[] ctrl_;
+	::operator delete(slots_);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::resizeForce_(unsigned newTableSize) {
+	int8_t *oldCtrl = ctrl_;
+	Entry *oldSlots = slots_;
+	unsigned oldTableSize = tableSize_;
+
+	allocate_(newTableSize);
+
+	for (unsigned i = 0; i < oldTableSize; i++) {
+		if (oldCtrl[i] >= 0) {
+			unsigned hash = mix_(hasher_(oldSlots[i].key));
+			unsigned j = findFirstNonFull_(hash);
+
+			new (slots_ + j) Entry(std::move(oldSlots[i]));
+			setCtrl_(j, (int8_t)(hash & 0x7F));
+			oldSlots[i].~Entry();
+		}
+	}
+
+	growthLeft_ -= entryCount_;
+	tombstoneCount_ = 0;
+
+	delete[] oldCtrl;
+	::operator delete(oldSlots);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::rehashAndGrow_() {
+	// mostly tombstones, rehashing at the same size frees up enough room
+	if (entryCount_ < maxLoad_(tableSize_) / 2)
+		resizeForce_(tableSize_);
+	else
+		resizeForce_(tableSize_ * 2);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::resize() {
+	unsigned newTableSize = FLAT_HASHMAP_GROUP_WIDTH;
+	while (maxLoad_(newTableSize) <= entryCount_)
+		newTableSize <<= 1;
+	resizeForce_(newTableSize);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline bool FlatHashMap<KeyT, DataT, HashT, KeyEqualT>::resize(unsigned newTableSize) {
+	newTableSize = roundUpTableSize_(newTableSize);
+	if (entryCount_ < maxLoad_(newTableSize)) {
+		resizeForce_(newTableSize);
+		return true;
+	}
+	return false;
+}
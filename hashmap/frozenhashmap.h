@@ -0,0 +1,326 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "chainedhashmap.h"
+
+// An immutable hashmap built from a ChainedHashMap with a minimal perfect hash
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// keys are split into small buckets, and each bucket is given a pilot value, found while building,
+// that sends every one of its keys to a different free slot, in the style of CHD and PTHash
+// a lookup reads one pilot and one slot, and verifies the slot with a single key comparison
+// the table holds exactly one entry per key, with no chains, nodes or empty slots
+
+#define FROZEN_HASHMAP_BUCKET_LOAD 4 // average number of keys sharing a pilot, higher takes less memory but builds slower
+
+template<typename KeyT, typename DataT, typename HashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>>
+class FrozenHashMap {
+public:
+	// element in hashmap
+	struct Entry {
+		KeyT key;
+		DataT data;
+
+		Entry(const KeyT &key, const DataT &data) : key(key), data(data) {}
+	};
+
+public:
+	// creates an empty map
+	FrozenHashMap(const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	// builds a map holding a copy of every entry in map
+	// map's hasher and key equality should agree with the given ones
+	template<bool StoreHash>
+	FrozenHashMap(const ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash> &map,
+		const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	// builds a map holding a copy of every entry, keys must not repeat
+	// for keys that are already gathered, saves building a ChainedHashMap just to freeze it
+	FrozenHashMap(const std::vector<Entry> &entries, const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	// search for the data associated with the given key
+	// returns pointer to key's associated data if found, if not found, returns nullptr
+	const DataT * find(const KeyT &key) const;
+
+	// number of entries hashmap is storing
+	unsigned entries() const;
+
+	// size of internal table
+	unsigned tableSize() const;
+
+	// bytes of memory taken by the map, including its table and pilots
+	std::size_t bytes() const;
+
+protected:
+	HashT hasher_;
+	KeyEqualT keyEqual_;
+
+	// mixed into every hash, changed when a build fails to find pilots
+	std::uint64_t seed_;
+
+	// every entry, each at the slot its key's hash and bucket's pilot send it to
+	std::vector<Entry> table_;
+
+	// pilot of each bucket
+	std::vector<std::uint32_t> pilots_;
+
+	// entry whose full hash equals another entry's, kept with that hash
+	struct OverflowEntry {
+		std::uint64_t hash;
+		Entry entry;
+
+		OverflowEntry(std::uint64_t hash, const KeyT &key, const DataT &data) : hash(hash), entry(key, data) {}
+	};
+
+	// entries no pilot can separate from another with the same hash, sorted by hash
+	// a lookup only compares keys against the ones sharing its hash, found by binary search
+	// stays empty unless the hasher collides
+	std::vector<OverflowEntry> overflow_;
+
+protected:
+	// key and data of an entry to be placed
+	typedef std::pair<const KeyT *, const DataT *> Source;
+
+protected:
+	// places every entry, trying seeds until one works
+	void build_(const std::vector<Source> &source);
+
+	// tries to place every entry using the given seed
+	// false if some bucket found no pilot, leaving the map to be rebuilt with another seed
+	bool tryBuild_(const std::vector<Source> &source, std::uint64_t seed);
+
+	// hash of a key, mixed with the seed
+	std::uint64_t hash_(const KeyT &key) const { return mix_((std::uint64_t)hasher_(key) ^ seed_); }
+
+	// bucket a hash belongs to, from its upper half
+	unsigned bucketOf_(std::uint64_t hash) const { return reduce_(hash >> 32, (unsigned)pilots_.size()); }
+
+	// slot a hash is sent to by the given pilot
+	unsigned slotOf_(std::uint64_t hash, std::uint32_t pilot) const {
+		return reduce_(mix_(hash ^ (pilot * 0x9e3779b97f4a7c15ull)), (unsigned)table_.size());
+	}
+
+	// maps the lower 32 bits of h into [0, range) with a multiply instead of a division
+	static unsigned reduce_(std::uint64_t h, unsigned range) { return (unsigned)(((h & 0xffffffffull) * range) >> 32); }
+
+	// 64 bit finalizer from murmurhash3, every bit of h affects every bit of the result
+	static std::uint64_t mix_(std::uint64_t h);
+};
+
+
+// builds an immutable FrozenHashMap holding a copy of every entry in map
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+FrozenHashMap<KeyT, DataT, HashT, KeyEqualT> freeze(const ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash> &map,
+	const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::FrozenHashMap(const HashT &hasher, const KeyEqualT &keyEqual)
+	: hasher_(hasher), keyEqual_(keyEqual), seed_(0)
+{}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+template<bool StoreHash>
+FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::FrozenHashMap(const ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash> &map,
+	const HashT &hasher, const KeyEqualT &keyEqual)
+	: hasher_(hasher), keyEqual_(keyEqual), seed_(0)
+{
+	typedef typename ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Entry SourceEntry;
+
+	std::vector<Source> source;
+	source.reserve(map.entries());
+	map.forEach([&](const SourceEntry &e) { source.emplace_back(&e.key, &e.data); });
+	build_(source);
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::FrozenHashMap(const std::vector<Entry> &entries, const HashT &hasher, const KeyEqualT &keyEqual)
+	: hasher_(hasher), keyEqual_(keyEqual), seed_(0)
+{
+	std::vector<Source> source;
+	source.reserve(entries.size());
+	for (const Entry &e : entries)
+		source.emplace_back(&e.key, &e.data);
+	build_(source);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::build_(const std::vector<Source> &source) {
+	for (std::uint64_t attempt = 1; !tryBuild_(source, attempt * 0x9e3779b97f4a7c15ull); attempt++) {}
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+bool FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::tryBuild_(const std::vector<Source> &source, std::uint64_t seed) {
+	unsigned n = (unsigned)source.size();
+	seed_ = seed;
+	table_.clear();
+	overflow_.clear();
+	pilots_.assign(n / FROZEN_HASHMAP_BUCKET_LOAD + 1, 0);
+	unsigned bucketCount = (unsigned)pilots_.size();
+
+	std::vector<std::uint64_t> hashes(n);
+	for (unsigned i = 0; i < n; i++)
+		hashes[i] = hash_(*source[i].first);
+
+	// counting sort of entries by bucket
+	std::vector<unsigned> bucketStart(bucketCount + 1, 0);
+	for (unsigned i = 0; i < n; i++)
+		bucketStart[bucketOf_(hashes[i]) + 1]++;
+	for (unsigned b = 0; b < bucketCount; b++)
+		bucketStart[b + 1] += bucketStart[b];
+
+	std::vector<unsigned> byBucket(n);
+	std::vector<unsigned> next(bucketStart.begin(), bucketStart.end() - 1);
+	for (unsigned i = 0; i < n; i++)
+		byBucket[next[bucketOf_(hashes[i])]++] = i;
+
+	// equal hashes always share a bucket, sorting it by hash puts them next to each other,
+	// and all but the first of them go to overflow
+	std::vector<bool> overflowed(n, false);
+	unsigned placed = n;
+	unsigned largestBucket = 0;
+	for (unsigned b = 0; b < bucketCount; b++) {
+		std::sort(byBucket.begin() + bucketStart[b], byBucket.begin() + bucketStart[b + 1],
+			[&](unsigned i, unsigned j) { return hashes[i] < hashes[j]; });
+
+		for (unsigned i = bucketStart[b] + 1; i < bucketStart[b + 1]; i++) {
+			if (hashes[byBucket[i]] == hashes[byBucket[i - 1]]) {
+				overflowed[byBucket[i]] = true;
+				placed--;
+			}
+		}
+		if (largestBucket < bucketStart[b + 1] - bucketStart[b])
+			largestBucket = bucketStart[b + 1] - bucketStart[b];
+	}
+
+	// largest buckets are the hardest to place, so they get pilots first while the table is emptiest
+	std::vector<unsigned> sizeStart(largestBucket + 2, 0);
+	for (unsigned b = 0; b < bucketCount; b++)
+		sizeStart[largestBucket - (bucketStart[b + 1] - bucketStart[b]) + 1]++;
+	for (unsigned s = 0; s <= largestBucket; s++)
+		sizeStart[s + 1] += sizeStart[s];
+
+	std::vector<unsigned> bySize(bucketCount);
+	for (unsigned b = 0; b < bucketCount; b++)
+		bySize[sizeStart[largestBucket - (bucketStart[b + 1] - bucketStart[b])]++] = b;
+
+	// the table only needs its size while searching for pilots, it is filled in once every slot is known
+	table_.reserve(placed);
+	std::vector<unsigned> entryAt(placed);
+	std::vector<bool> taken(placed, false);
+
+	// expected tries for the last free slot is placed, far beyond that the seed is bad
+	std::uint64_t maxPilot = 16 * (std::uint64_t)placed + 1024;
+	if (maxPilot > 0xffffffffull)
+		maxPilot = 0xffffffffull;
+
+	std::vector<unsigned> slots;
+	for (unsigned b : bySize) {
+		std::uint64_t pilot = 0;
+		for (;; pilot++) {
+			if (pilot > maxPilot)
+				return false;
+
+			slots.clear();
+			bool fits = true;
+			for (unsigned i = bucketStart[b]; i < bucketStart[b + 1] && fits; i++) {
+				if (overflowed[byBucket[i]])
+					continue;
+
+				unsigned s = reduce_(mix_(hashes[byBucket[i]] ^ (pilot * 0x9e3779b97f4a7c15ull)), placed);
+				if (taken[s])
+					fits = false;
+				else {
+					taken[s] = true;
+					slots.push_back(s);
+				}
+			}
+			if (fits)
+				break;
+			for (unsigned s : slots)
+				taken[s] = false;
+		}
+
+		pilots_[b] = (std::uint32_t)pilot;
+		for (unsigned i = bucketStart[b], k = 0; i < bucketStart[b + 1]; i++) {
+			if (!overflowed[byBucket[i]])
+				entryAt[slots[k++]] = byBucket[i];
+		}
+	}
+
+	for (unsigned s = 0; s < placed; s++)
+		table_.emplace_back(*source[entryAt[s]].first, *source[entryAt[s]].second);
+	for (unsigned i = 0; i < n; i++) {
+		if (overflowed[i])
+			overflow_.emplace_back(hashes[i], *source[i].first, *source[i].second);
+	}
+	std::sort(overflow_.begin(), overflow_.end(), [](const OverflowEntry &a, const OverflowEntry &b) { return a.hash < b.hash; });
+	return true;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline const DataT * FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::find(const KeyT &key) const {
+	if (table_.empty())
+		return nullptr;
+
+	std::uint64_t hash = hash_(key);
+	const Entry &e = table_[slotOf_(hash, pilots_[bucketOf_(hash)])];
+	if (keyEqual_(e.key, key))
+		return &e.data;
+
+	if (overflow_.empty())
+		return nullptr;
+
+	// only entries with the same hash as key can hold it
+	typename std::vector<OverflowEntry>::const_iterator o = std::lower_bound(overflow_.begin(), overflow_.end(), hash,
+		[](const OverflowEntry &a, std::uint64_t h) { return a.hash < h; });
+	for (; o != overflow_.end() && o->hash == hash; ++o) {
+		if (keyEqual_(o->entry.key, key))
+			return &o->entry.data;
+	}
+	return nullptr;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::entries() const {
+	return (unsigned)(table_.size() + overflow_.size());
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::tableSize() const {
+	return (unsigned)table_.size();
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline std::size_t FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::bytes() const {
+	return sizeof(*this) + table_.capacity() * sizeof(Entry) + pilots_.capacity() * sizeof(std::uint32_t)
+		+ overflow_.capacity() * sizeof(OverflowEntry);
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline std::uint64_t FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>::mix_(std::uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+inline FrozenHashMap<KeyT, DataT, HashT, KeyEqualT> freeze(const ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash> &map,
+	const HashT &hasher, const KeyEqualT &keyEqual) {
+	return FrozenHashMap<KeyT, DataT, HashT, KeyEqualT>(map, hasher, keyEqual);
+}
@@ -0,0 +1,270 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "chainedhashmap.h"
+
+// A read-only hashmap answered straight out of a memory mapped snapshot file
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// writeSnapshot saves a populated ChainedHashMap, and MappedHashMap maps that file and searches it
+// without deserializing anything, so loading is near instant and the pages are shared between
+// every process mapping the same file. uses POSIX mmap.
+//
+// snapshot layout, every offset is from the start of the file so it can be mapped at any address:
+//   header
+//   buckets: bucketCount + 1 entry indices, bucket b holds entries [buckets[b], buckets[b + 1])
+//   entries: entryCount records of { hash, key, data }, grouped by bucket
+//
+// keys and data must be trivially copyable, and HashT must hash a key the same way in every process
+// that reads the file, which rules out hashers seeded per process.
+
+#define MAPPED_HASHMAP_MAGIC "CHMSNAP" // first bytes of every snapshot file, followed by a null
+#define MAPPED_HASHMAP_VERSION 1 // bumped whenever the layout changes
+
+// header at the start of a snapshot file
+struct MappedHashMapHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t keySize, dataSize, recordSize; // checked against the types reading the file
+	std::uint64_t bucketCount, entryCount;
+	std::uint64_t bucketsOffset, recordsOffset;
+};
+
+
+// one entry as stored in a snapshot file
+template<typename KeyT, typename DataT>
+struct MappedHashMapRecord {
+	std::uint64_t hash;
+	KeyT key;
+	DataT data;
+};
+
+
+// saves a hashmap to a snapshot file that MappedHashMap can open
+// buckets are sized for about one entry each, regardless of the map's own table size
+// true if the whole file was written
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+bool writeSnapshot(const ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash> &map, const char *path, const HashT &hasher = HashT());
+
+
+template<typename KeyT, typename DataT, typename HashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>>
+class MappedHashMap {
+	static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<DataT>::value,
+		"snapshot keys and data must be trivially copyable");
+
+public:
+	typedef MappedHashMapRecord<KeyT, DataT> Record;
+
+public:
+	// creates an empty map, open() a snapshot to use it
+	MappedHashMap(const HashT &hasher = HashT(), const KeyEqualT &keyEqual = KeyEqualT());
+
+	MappedHashMap(const MappedHashMap &map) = delete;
+	MappedHashMap & operator=(const MappedHashMap &map) = delete;
+
+	~MappedHashMap();
+
+	// maps a snapshot file written by writeSnapshot with the same key and data types
+	// false if the file could not be mapped or is not a valid snapshot for these types
+	bool open(const char *path);
+
+	// unmaps the current snapshot
+	void close();
+
+	// true if a snapshot is mapped
+	bool isOpen() const;
+
+	// search for the data associated with the given key
+	// returns pointer to key's associated data in the mapping if found, if not found, returns nullptr
+	const DataT * find(const KeyT &key) const;
+
+	// number of entries in snapshot
+	unsigned entries() const;
+
+	// number of buckets in snapshot
+	unsigned tableSize() const;
+
+protected:
+	HashT hasher_;
+	KeyEqualT keyEqual_;
+
+	// whole file as mapped
+	void *mapping_;
+	std::size_t mappingSize_;
+
+	// parts of the mapping
+	const MappedHashMapHeader *header_;
+	const std::uint64_t *buckets_;
+	const Record *records_;
+};
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT, bool StoreHash>
+bool writeSnapshot(const ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash> &map, const char *path, const HashT &hasher) {
+	static_assert(std::is_trivially_copyable<KeyT>::value && std::is_trivially_copyable<DataT>::value,
+		"snapshot keys and data must be trivially copyable");
+	typedef MappedHashMapRecord<KeyT, DataT> Record;
+
+	MappedHashMapHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, MAPPED_HASHMAP_MAGIC, sizeof(MAPPED_HASHMAP_MAGIC));
+	header.version = MAPPED_HASHMAP_VERSION;
+	header.keySize = sizeof(KeyT);
+	header.dataSize = sizeof(DataT);
+	header.recordSize = sizeof(Record);
+	header.entryCount = map.entries();
+	header.bucketCount = (map.entries() > 0) ? map.entries() : 1;
+	header.bucketsOffset = sizeof(MappedHashMapHeader);
+
+	// records start on a cache line, so none straddle two more than they have to
+	std::uint64_t bucketsEnd = header.bucketsOffset + (header.bucketCount + 1) * sizeof(std::uint64_t);
+	header.recordsOffset = (bucketsEnd + 63) / 64 * 64;
+
+	// counting sort of every entry by bucket
+	std::vector<std::uint64_t> buckets(header.bucketCount + 1, 0);
+	map.forEach([&](const typename ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Entry &e) {
+		buckets[hasher(e.key) % header.bucketCount + 1]++;
+	});
+	for (std::uint64_t b = 1; b <= header.bucketCount; b++)
+		buckets[b] += buckets[b - 1];
+
+	// zeroed so padding in records is written out deterministically
+	std::vector<Record> records(header.entryCount);
+	if (!records.empty())
+		std::memset(static_cast<void *>(records.data()), 0, records.size() * sizeof(Record));
+
+	std::vector<std::uint64_t> next(buckets.begin(), buckets.end() - 1);
+	map.forEach([&](const typename ChainedHashMap<KeyT, DataT, HashT, KeyEqualT, StoreHash>::Entry &e) {
+		std::uint64_t hash = hasher(e.key);
+		Record &r = records[next[hash % header.bucketCount]++];
+		r.hash = hash;
+		std::memcpy(static_cast<void *>(&r.key), &e.key, sizeof(KeyT));
+		std::memcpy(static_cast<void *>(&r.data), &e.data, sizeof(DataT));
+	});
+
+	std::FILE *file = std::fopen(path, "wb");
+	if (file == nullptr)
+		return false;
+
+	static const char padding[64] = {};
+	bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+		&& std::fwrite(buckets.data(), sizeof(std::uint64_t), buckets.size(), file) == buckets.size()
+		&& std::fwrite(padding, 1, header.recordsOffset - bucketsEnd, file) == header.recordsOffset - bucketsEnd
+		&& (records.empty() || std::fwrite(records.data(), sizeof(Record), records.size(), file) == records.size());
+
+	return (std::fclose(file) == 0) && written;
+}
+
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::MappedHashMap(const HashT &hasher, const KeyEqualT &keyEqual)
+	: hasher_(hasher), keyEqual_(keyEqual), mapping_(nullptr), mappingSize_(0),
+	  header_(nullptr), buckets_(nullptr), records_(nullptr)
+{}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::~MappedHashMap() {
+	close();
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+bool MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::open(const char *path) {
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (std::size_t)info.st_size < sizeof(MappedHashMapHeader)) {
+		::close(fd);
+		return false;
+	}
+
+	// the mapping stays valid after its file descriptor is closed
+	void *mapping = mmap(nullptr, (std::size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED)
+		return false;
+
+	mapping_ = mapping;
+	mappingSize_ = (std::size_t)info.st_size;
+
+	const unsigned char *base = static_cast<const unsigned char *>(mapping_);
+	const MappedHashMapHeader *header = reinterpret_cast<const MappedHashMapHeader *>(base);
+
+	// counts are compared against the room left in the file by division, so a corrupt header cant overflow a check
+	bool valid = std::memcmp(header->magic, MAPPED_HASHMAP_MAGIC, sizeof(MAPPED_HASHMAP_MAGIC)) == 0
+		&& header->version == MAPPED_HASHMAP_VERSION
+		&& header->keySize == sizeof(KeyT) && header->dataSize == sizeof(DataT) && header->recordSize == sizeof(Record)
+		&& header->bucketsOffset >= sizeof(MappedHashMapHeader) && header->bucketsOffset % alignof(std::uint64_t) == 0
+		&& header->bucketsOffset <= header->recordsOffset && header->recordsOffset <= mappingSize_
+		&& header->recordsOffset % alignof(Record) == 0
+		&& header->bucketCount > 0
+		&& header->bucketCount < (header->recordsOffset - header->bucketsOffset) / sizeof(std::uint64_t)
+		&& header->entryCount <= (mappingSize_ - header->recordsOffset) / sizeof(Record);
+
+	if (!valid) {
+		close();
+		return false;
+	}
+
+	header_ = header;
+	buckets_ = reinterpret_cast<const std::uint64_t *>(base + header->bucketsOffset);
+	records_ = reinterpret_cast<const Record *>(base + header->recordsOffset);
+	return true;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline void MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::close() {
+	if (mapping_ != nullptr)
+		munmap(mapping_, mappingSize_);
+	mapping_ = nullptr;
+	mappingSize_ = 0;
+	header_ = nullptr;
+	buckets_ = nullptr;
+	records_ = nullptr;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline bool MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::isOpen() const {
+	return header_ != nullptr;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline const DataT * MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::find(const KeyT &key) const {
+	if (header_ == nullptr)
+		return nullptr;
+
+	std::uint64_t hash = hasher_(key);
+	std::uint64_t bucket = hash % header_->bucketCount;
+
+	for (std::uint64_t i = buckets_[bucket], end = buckets_[bucket + 1]; i < end && i < header_->entryCount; i++) {
+		if (records_[i].hash == hash && keyEqual_(records_[i].key, key))
+			return &records_[i].data;
+	}
+	return nullptr;
+}
+
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::entries() const {
+	return (header_ == nullptr) ? 0 : (unsigned)header_->entryCount;
+}
+
+template<typename KeyT, typename DataT, typename HashT, typename KeyEqualT>
+inline unsigned MappedHashMap<KeyT, DataT, HashT, KeyEqualT>::tableSize() const {
+	return (header_ == nullptr) ? 0 : (unsigned)header_->bucketCount;
+}
@@ -0,0 +1,409 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+#include "../nodepool/epochreclaimer.h"
+
+// Concurrent Queues
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// first in first out queues any number of threads can push to and pop from at once, without locks
+//
+// ConcurrentQueue is unbounded, a singly linked list of nodes with a dummy node at the front (Michael and Scott)
+// pushes link a node after the last one, pops move the front past the dummy, and the popped value's node becomes
+// the new dummy. unlinked dummies are freed through an EpochReclaimer once no pop can still be reading them
+// nodes come from AllocT rebound to the node type, it must be safe to call from any thread, so std::allocator
+// is the default instead of a NodePool
+//
+// BoundedQueue is a fixed ring of slots, each with a sequence number saying whose turn it is (Vyukov),
+// it never allocates after being made, and push fails or waits when it is full
+
+#define CONCURRENT_QUEUE_CACHE_LINE 64 // size the ends of a queue are padded to, so producers and consumers dont share a line
+
+template<typename T, typename AllocT = std::allocator<T>>
+class ConcurrentQueue {
+protected:
+	// queue node, value is constructed in every node but the dummy
+	class Node {
+	public:
+		std::atomic<Node *> next;
+		Node *retiredNext; // link while waiting to be freed
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		Node() : next(nullptr), retiredNext(nullptr) {}
+
+		T * value() { return reinterpret_cast<T *>(storage); }
+	};
+
+	typedef typename std::allocator_traits<AllocT>::template rebind_alloc<Node> NodeAllocT;
+	typedef std::allocator_traits<NodeAllocT> NodeTraits;
+
+protected:
+	NodeAllocT alloc_;
+	mutable EpochReclaimer<Node> reclaimer_;
+
+	alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<Node *> head_; // dummy node, the front is after it
+	alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<Node *> tail_; // last node, or one behind it while a push finishes
+
+protected:
+	// allocates a node, without a value
+	Node * newNode_();
+
+	// gives a node's memory back, its value must already be destroyed
+	void deleteNode_(Node *node);
+
+	// frees a list of nodes linked through retiredNext
+	void deleteRetired_(Node *node);
+
+	// links a node holding a value onto the end
+	void pushNode_(Node *node);
+
+public:
+	ConcurrentQueue();
+	explicit ConcurrentQueue(const AllocT &alloc);
+
+	ConcurrentQueue(const ConcurrentQueue &queue) = delete;
+	ConcurrentQueue & operator=(const ConcurrentQueue &queue) = delete;
+
+	// no other thread may be using the queue
+	~ConcurrentQueue();
+
+	// adds an element to the back
+	void push(const T &value);
+	void push(T &&value);
+
+	// constructs an element in place at the back
+	template<typename... ArgsT>
+	void emplace(ArgsT&&... args);
+
+	// moves the front element into out and removes it
+	// false if the queue was empty
+	bool tryPop(T &out);
+
+	// removes and returns the front element, waiting for one if the queue is empty
+	T pop();
+
+	// true if the queue was empty when checked, other threads may have changed it since
+	bool empty() const;
+};
+
+
+template<typename T>
+class BoundedQueue {
+protected:
+	// ring slot, sequence == position means it is free for the push at position,
+	// sequence == position + 1 means it holds the value for the pop at position
+	struct alignas(CONCURRENT_QUEUE_CACHE_LINE) Slot {
+		std::atomic<std::size_t> sequence;
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		T * value() { return reinterpret_cast<T *>(storage); }
+	};
+
+protected:
+	Slot *slots_;
+	std::size_t mask_; // capacity - 1
+
+	alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<std::size_t> pushPos_; // position of the next push
+	alignas(CONCURRENT_QUEUE_CACHE_LINE) std::atomic<std::size_t> popPos_;  // position of the next pop
+
+protected:
+	// claims the slot for the next push, nullptr if the queue is full
+	Slot * claimPush_(std::size_t &pos);
+
+public:
+	// creates a queue holding up to capacity elements, rounded up to a power of 2
+	explicit BoundedQueue(std::size_t capacity);
+
+	BoundedQueue(const BoundedQueue &queue) = delete;
+	BoundedQueue & operator=(const BoundedQueue &queue) = delete;
+
+	// no other thread may be using the queue
+	~BoundedQueue();
+
+	// most elements the queue can hold
+	std::size_t capacity() const { return mask_ + 1; }
+
+	// adds an element to the back
+	// false if the queue was full
+	bool tryPush(const T &value);
+	bool tryPush(T &&value);
+
+	// adds an element to the back, waiting for room if the queue is full
+	void push(const T &value);
+	void push(T &&value);
+
+	// moves the front element into out and removes it
+	// false if the queue was empty
+	bool tryPop(T &out);
+
+	// removes and returns the front element, waiting for one if the queue is empty
+	T pop();
+};
+
+
+
+
+template<typename T, typename AllocT>
+inline ConcurrentQueue<T, AllocT>::ConcurrentQueue() : ConcurrentQueue(AllocT()) {
+}
+
+template<typename T, typename AllocT>
+ConcurrentQueue<T, AllocT>::ConcurrentQueue(const AllocT &alloc) : alloc_(alloc) {
+	Node *dummy = newNode_();
+	head_.store(dummy, std::memory_order_relaxed);
+	tail_.store(dummy, std::memory_order_relaxed);
+}
+
+template<typename T, typename AllocT>
+ConcurrentQueue<T, AllocT>::~ConcurrentQueue() {
+	deleteRetired_(reclaimer_.drain());
+
+	Node *node = head_.load(std::memory_order_relaxed);
+	Node *next = node->next.load(std::memory_order_relaxed);
+	deleteNode_(node);
+
+	while (next != nullptr) {
+		node = next;
+		next = node->next.load(std::memory_order_relaxed);
+		node->value()->~T();
+		deleteNode_(node);
+	}
+}
+
+
+
+template<typename T, typename AllocT>
+inline typename ConcurrentQueue<T, AllocT>::Node * ConcurrentQueue<T, AllocT>::newNode_() {
+	Node *node = NodeTraits::allocate(alloc_, 1);
+	NodeTraits::construct(alloc_, node);
+	return node;
+}
+
+template<typename T, typename AllocT>
+inline void ConcurrentQueue<T, AllocT>::deleteNode_(Node *node) {
+	NodeTraits::destroy(alloc_, node);
+	NodeTraits::deallocate(alloc_, node, 1);
+}
+
+template<typename T, typename AllocT>
+inline void ConcurrentQueue<T, AllocT>::deleteRetired_(Node *node) {
+	while (node != nullptr) {
+		Node *temp = node;
+		node = node->retiredNext;
+		deleteNode_(temp);
+	}
+}
+
+template<typename T, typename AllocT>
+void ConcurrentQueue<T, AllocT>::pushNode_(Node *node) {
+	typename EpochReclaimer<Node>::Guard guard = reclaimer_.pin();
+
+	for (;;) {
+		Node *last = tail_.load(std::memory_order_acquire);
+		Node *next = last->next.load(std::memory_order_acquire);
+
+		if (next != nullptr) {
+			// another push linked its node but hasnt moved tail_ yet, help it along
+			tail_.compare_exchange_weak(last, next, std::memory_order_release, std::memory_order_relaxed);
+			continue;
+		}
+
+		if (last->next.compare_exchange_weak(next, node, std::memory_order_release, std::memory_order_relaxed)) {
+			tail_.compare_exchange_strong(last, node, std::memory_order_release, std::memory_order_relaxed);
+			return;
+		}
+	}
+}
+
+
+
+template<typename T, typename AllocT>
+inline void ConcurrentQueue<T, AllocT>::push(const T &value) {
+	emplace(value);
+}
+
+template<typename T, typename AllocT>
+inline void ConcurrentQueue<T, AllocT>::push(T &&value) {
+	emplace(std::move(value));
+}
+
+template<typename T, typename AllocT>
+template<typename... ArgsT>
+void ConcurrentQueue<T, AllocT>::emplace(ArgsT&&... args) {
+	Node *node = newNode_();
+	try {
+		new (node->storage) T(std::forward<ArgsT>(args)...);
+	}
+	catch (...) {
+		deleteNode_(node);
+		throw;
+	}
+	pushNode_(node);
+}
+
+template<typename T, typename AllocT>
+bool ConcurrentQueue<T, AllocT>::tryPop(T &out) {
+	Node *freed;
+	{
+		typename EpochReclaimer<Node>::Guard guard = reclaimer_.pin();
+
+		Node *first, *next;
+		for (;;) {
+			first = head_.load(std::memory_order_acquire);
+			next = first->next.load(std::memory_order_acquire);
+			if (next == nullptr)
+				return false;
+
+			// tail_ must never be left behind head_, or a push could link onto a freed node
+			Node *last = tail_.load(std::memory_order_acquire);
+			if (first == last) {
+				tail_.compare_exchange_weak(last, next, std::memory_order_release, std::memory_order_relaxed);
+				continue;
+			}
+
+			if (head_.compare_exchange_weak(first, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+				break;
+		}
+
+		// next is the new dummy, only the pop that moved head_ onto it touches its value
+		out = std::move(*next->value());
+		next->value()->~T();
+
+		freed = reclaimer_.retire(guard, first);
+	}
+	deleteRetired_(freed);
+	return true;
+}
+
+template<typename T, typename AllocT>
+T ConcurrentQueue<T, AllocT>::pop() {
+	T out;
+	while (!tryPop(out))
+		std::this_thread::yield();
+	return out;
+}
+
+template<typename T, typename AllocT>
+bool ConcurrentQueue<T, AllocT>::empty() const {
+	typename EpochReclaimer<Node>::Guard guard = reclaimer_.pin();
+	return head_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) == nullptr;
+}
+
+
+
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(std::size_t capacity) : pushPos_(0), popPos_(0) {
+	std::size_t size = 2;
+	while (size < capacity)
+		size *= 2;
+	mask_ = size - 1;
+
+	slots_ = static_cast<Slot *>(::operator new(size * sizeof(Slot), std::align_val_t(alignof(Slot))));
+	for (std::size_t i = 0; i < size; i++)
+		new (&slots_[i].sequence) std::atomic<std::size_t>(i);
+}
+
+template<typename T>
+BoundedQueue<T>::~BoundedQueue() {
+	std::size_t end = pushPos_.load(std::memory_order_relaxed);
+	for (std::size_t pos = popPos_.load(std::memory_order_relaxed); pos != end; pos++)
+		slots_[pos & mask_].value()->~T();
+	::operator delete(slots_, std::align_val_t(alignof(Slot)));
+}
+
+
+
+template<typename T>
+typename BoundedQueue<T>::Slot * BoundedQueue<T>::claimPush_(std::size_t &pos) {
+	pos = pushPos_.load(std::memory_order_relaxed);
+	for (;;) {
+		Slot *slot = &slots_[pos & mask_];
+		std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+
+		if (diff == 0) {
+			if (pushPos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				return slot;
+		}
+		else if (diff < 0)
+			return nullptr; // slot still holds the value from a lap ago
+		else
+			pos = pushPos_.load(std::memory_order_relaxed);
+	}
+}
+
+template<typename T>
+bool BoundedQueue<T>::tryPush(const T &value) {
+	std::size_t pos;
+	Slot *slot = claimPush_(pos);
+	if (slot == nullptr)
+		return false;
+
+	new (slot->storage) T(value);
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+bool BoundedQueue<T>::tryPush(T &&value) {
+	std::size_t pos;
+	Slot *slot = claimPush_(pos);
+	if (slot == nullptr)
+		return false;
+
+	new (slot->storage) T(std::move(value));
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+void BoundedQueue<T>::push(const T &value) {
+	while (!tryPush(value))
+		std::this_thread::yield();
+}
+
+template<typename T>
+void BoundedQueue<T>::push(T &&value) {
+	while (!tryPush(std::move(value)))
+		std::this_thread::yield();
+}
+
+template<typename T>
+bool BoundedQueue<T>::tryPop(T &out) {
+	std::size_t pos = popPos_.load(std::memory_order_relaxed);
+	Slot *slot;
+	for (;;) {
+		slot = &slots_[pos & mask_];
+		std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(pos + 1);
+
+		if (diff == 0) {
+			if (popPos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+			return false; // slot hasnt been pushed to yet
+		else
+			pos = popPos_.load(std::memory_order_relaxed);
+	}
+
+	out = std::move(*slot->value());
+	slot->value()->~T();
+
+	// free for the push one lap later
+	slot->sequence.store(pos + mask_ + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T>
+T BoundedQueue<T>::pop() {
+	T out;
+	while (!tryPop(out))
+		std::this_thread::yield();
+	return out;
+}
@@ -0,0 +1,482 @@
+#pragma once
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include "../nodepool/nodepool.h"
+
+// Indexed List
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// a list kept as an implicit treap, a tree ordered by position instead of key, balanced by random priorities
+// every node knows the size of its subtree, so finding, inserting and removing by index are O(log n) expected,
+// and the list can be split in two or have another list appended in O(log n) expected
+// elements never move between nodes, so iterators stay valid until their element is removed
+//
+// nodes come from AllocT rebound to the node type, a NodePool by default
+// split() and concat() hand nodes between lists sharing an allocator, which for a NodePool means sharing the pool,
+// so lists made by split() must stay on the same thread as the list they came from
+
+template<typename T, typename AllocT = PoolAllocator<T>>
+class IndexedList {
+protected:
+	// treap node, its position in the list is the number of nodes before it in order
+	class Node {
+	public:
+		T value;
+		Node *left, *right, *parent;
+		unsigned priority; // larger than every priority below it
+		unsigned count;    // number of nodes in subtree, including this one
+
+		Node(const T &value, unsigned priority)
+			: value(value), left(nullptr), right(nullptr), parent(nullptr), priority(priority), count(1) {}
+	};
+
+	typedef typename std::allocator_traits<AllocT>::template rebind_alloc<Node> NodeAllocT;
+	typedef std::allocator_traits<NodeAllocT> NodeTraits;
+
+public:
+	class Iterator;
+
+protected:
+	NodeAllocT alloc_;
+	Node *head_;     // root of the treap
+	unsigned seed_;  // xorshift state for priorities
+
+protected:
+	// number of nodes in a subtree
+	static unsigned count_(const Node *n_ptr) { return (n_ptr == nullptr) ? 0 : n_ptr->count; }
+
+	// sets a node's subtree size and its children's parent links, returns n_ptr
+	static Node * update_(Node *n_ptr);
+
+	// node at given index, nullptr if past the end
+	Node * at_(unsigned index) const;
+
+	// smallest and largest nodes in a subtree
+	static Node * first_(Node *n_ptr);
+	static Node * last_(Node *n_ptr);
+
+	// next and previous nodes in order, nullptr past either end
+	static Node * successor_(Node *n_ptr);
+	static Node * predecessor_(Node *n_ptr);
+
+	// joins two subtrees, every element of a before every element of b, returns the new root
+	static Node * merge_(Node *a, Node *b);
+
+	// splits the first k elements of a subtree off into l, the rest into r
+	// parent links of l and r themselves are left for the caller
+	static void split_(Node *n_ptr, unsigned k, Node *&l, Node *&r);
+
+	// next random priority
+	unsigned priority_();
+
+	// allocates and constructs a node
+	Node * newNode_(const T &value);
+
+	// destroys a node and gives its memory back
+	void deleteNode_(Node *n_ptr);
+
+	// deletes every node in a subtree
+	void destroy_(Node *n_ptr);
+
+	// copies a subtree, keeping its shape and priorities
+	Node * copy_(const Node *n_ptr, Node *parent);
+
+	// empty list sharing an already rebound allocator
+	IndexedList(const NodeAllocT &alloc, unsigned seed);
+
+public:
+	IndexedList();
+	explicit IndexedList(const AllocT &alloc);
+	IndexedList(const IndexedList &list);
+	IndexedList(IndexedList &&list);
+	IndexedList(const std::initializer_list<T> &list, const AllocT &alloc = AllocT());
+	~IndexedList();
+
+	IndexedList & operator=(const IndexedList &list) = delete;
+
+	unsigned size() const { return count_(head_); }
+
+	// clears entire list
+	void clear();
+
+	// inserts element at given position, pushes rest of the list forward, O(log n)
+	void insert(const unsigned i, const T & value);
+
+	// removes an element from list, O(log n)
+	void remove(const unsigned i);
+
+	// inserts element before the one pos points to, O(log n)
+	// returns iterator to the inserted element
+	Iterator insertBefore(Iterator pos, const T &value);
+
+	// removes the element it points to, O(log n)
+	// returns iterator to the element after it
+	Iterator erase(Iterator it);
+
+	// position of the element it points to, size() for end(), O(log n)
+	unsigned indexOf(Iterator it) const;
+
+	// removes elements i through the end and returns them as a new list sharing this one's allocator, O(log n)
+	IndexedList split(const unsigned i);
+
+	// moves every element of list onto the end of this one, leaving list empty
+	// O(log n) if both share an allocator, otherwise the elements are copied
+	void concat(IndexedList &list);
+
+	// access an element in the list, O(log n)
+	T & operator[](const unsigned i);
+	// get copy of an element in the list
+	T operator[](const unsigned i) const;
+
+	// iterator pointing to first element of list
+	Iterator start();
+	// iterator pointing to end + 1 of list
+	Iterator end();
+};
+
+
+// Iterator for indexed lists
+template<typename T, typename AllocT>
+class IndexedList<T, AllocT>::Iterator {
+	friend class IndexedList;
+
+	protected:
+		Node *it_;
+		const IndexedList *list_; // needed to step back from end()
+
+	public:
+		Iterator() : it_(nullptr), list_(nullptr) {}
+		Iterator(Node *ptr, const IndexedList *list) : it_(ptr), list_(list) {}
+
+		// advance iterator
+		Iterator next() const { return Iterator(successor_(it_), list_); }
+		// move iterator back, from end() moves to the last element
+		Iterator prev() const { return Iterator((it_ == nullptr) ? last_(list_->head_) : predecessor_(it_), list_); }
+
+		Iterator & operator++() { it_ = successor_(it_); return *this; }
+		Iterator operator++(int) { Iterator temp = *this; ++*this; return temp; }
+
+		Iterator & operator--() { return *this = prev(); }
+		Iterator operator--(int) { Iterator temp = *this; --*this; return temp; }
+
+		// dereferance iterator
+		T & operator*() { return it_->value; }
+		T operator*() const { return it_->value; }
+
+		bool operator==(const Iterator &it) const { return this->it_ == it.it_; }
+		bool operator!=(const Iterator &it) const { return this->it_ != it.it_; }
+};
+
+
+
+
+template<typename T, typename AllocT>
+inline IndexedList<T, AllocT>::IndexedList() : alloc_(AllocT()), head_(nullptr), seed_(2463534242u) {
+}
+
+template<typename T, typename AllocT>
+inline IndexedList<T, AllocT>::IndexedList(const AllocT &alloc) : alloc_(alloc), head_(nullptr), seed_(2463534242u) {
+}
+
+template<typename T, typename AllocT>
+inline IndexedList<T, AllocT>::IndexedList(const NodeAllocT &alloc, unsigned seed) : alloc_(alloc), head_(nullptr), seed_(seed) {
+}
+
+template<typename T, typename AllocT>
+inline IndexedList<T, AllocT>::IndexedList(const IndexedList &list)
+	: alloc_(NodeTraits::select_on_container_copy_construction(list.alloc_)), head_(nullptr), seed_(list.seed_) {
+	head_ = copy_(list.head_, nullptr);
+}
+
+template<typename T, typename AllocT>
+inline IndexedList<T, AllocT>::IndexedList(IndexedList &&list)
+	: alloc_(list.alloc_), head_(list.head_), seed_(list.seed_) {
+	list.head_ = nullptr;
+}
+
+template<typename T, typename AllocT>
+IndexedList<T, AllocT>::IndexedList(const std::initializer_list<T> &list, const AllocT &alloc)
+	: alloc_(alloc), head_(nullptr), seed_(2463534242u) {
+	for (const T &value : list)
+		head_ = merge_(head_, newNode_(value));
+}
+
+template<typename T, typename AllocT>
+inline IndexedList<T, AllocT>::~IndexedList() { clear(); }
+
+template<typename T, typename AllocT>
+inline void IndexedList<T, AllocT>::clear() {
+	// nodes are deleted one at a time, the allocator may be shared with lists made by split()
+	destroy_(head_);
+	head_ = nullptr;
+}
+
+
+
+template<typename T, typename AllocT>
+inline unsigned IndexedList<T, AllocT>::priority_() {
+	seed_ ^= seed_ << 13;
+	seed_ ^= seed_ >> 17;
+	seed_ ^= seed_ << 5;
+	return seed_;
+}
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::newNode_(const T &value) {
+	Node *n_ptr = NodeTraits::allocate(alloc_, 1);
+	NodeTraits::construct(alloc_, n_ptr, value, priority_());
+	return n_ptr;
+}
+
+template<typename T, typename AllocT>
+inline void IndexedList<T, AllocT>::deleteNode_(Node *n_ptr) {
+	NodeTraits::destroy(alloc_, n_ptr);
+	NodeTraits::deallocate(alloc_, n_ptr, 1);
+}
+
+template<typename T, typename AllocT>
+void IndexedList<T, AllocT>::destroy_(Node *n_ptr) {
+	// rotates left children up until there are none, so every node can be deleted on the way down the right
+	while (n_ptr != nullptr) {
+		if (n_ptr->left != nullptr) {
+			Node *left = n_ptr->left;
+			n_ptr->left = left->right;
+			left->right = n_ptr;
+			n_ptr = left;
+		}
+		else {
+			Node *right = n_ptr->right;
+			deleteNode_(n_ptr);
+			n_ptr = right;
+		}
+	}
+}
+
+template<typename T, typename AllocT>
+typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::copy_(const Node *n_ptr, Node *parent) {
+	if (n_ptr == nullptr)
+		return nullptr;
+
+	Node *n = NodeTraits::allocate(alloc_, 1);
+	NodeTraits::construct(alloc_, n, n_ptr->value, n_ptr->priority);
+	n->parent = parent;
+	n->count = n_ptr->count;
+	n->left = copy_(n_ptr->left, n);
+	n->right = copy_(n_ptr->right, n);
+	return n;
+}
+
+
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::update_(Node *n_ptr) {
+	n_ptr->count = count_(n_ptr->left) + count_(n_ptr->right) + 1;
+	if (n_ptr->left != nullptr)
+		n_ptr->left->parent = n_ptr;
+	if (n_ptr->right != nullptr)
+		n_ptr->right->parent = n_ptr;
+	return n_ptr;
+}
+
+template<typename T, typename AllocT>
+typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::merge_(Node *a, Node *b) {
+	if (a == nullptr)
+		return b;
+	if (b == nullptr)
+		return a;
+
+	// the higher priority root stays on top
+	if (a->priority > b->priority) {
+		a->right = merge_(a->right, b);
+		return update_(a);
+	}
+	b->left = merge_(a, b->left);
+	return update_(b);
+}
+
+template<typename T, typename AllocT>
+void IndexedList<T, AllocT>::split_(Node *n_ptr, unsigned k, Node *&l, Node *&r) {
+	if (n_ptr == nullptr) {
+		l = r = nullptr;
+		return;
+	}
+
+	unsigned left = count_(n_ptr->left);
+	if (k <= left) {
+		split_(n_ptr->left, k, l, n_ptr->left);
+		r = update_(n_ptr);
+	}
+	else {
+		split_(n_ptr->right, k - left - 1, n_ptr->right, r);
+		l = update_(n_ptr);
+	}
+}
+
+template<typename T, typename AllocT>
+typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::at_(unsigned index) const {
+	Node *n_ptr = head_;
+
+	while (n_ptr != nullptr) {
+		unsigned left = count_(n_ptr->left);
+		if (index == left)
+			return n_ptr;
+
+		if (index < left)
+			n_ptr = n_ptr->left;
+		else {
+			index -= left + 1;
+			n_ptr = n_ptr->right;
+		}
+	}
+	return nullptr;
+}
+
+
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::first_(Node *n_ptr) {
+	if (n_ptr != nullptr) {
+		while (n_ptr->left != nullptr)
+			n_ptr = n_ptr->left;
+	}
+	return n_ptr;
+}
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::last_(Node *n_ptr) {
+	if (n_ptr != nullptr) {
+		while (n_ptr->right != nullptr)
+			n_ptr = n_ptr->right;
+	}
+	return n_ptr;
+}
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::successor_(Node *n_ptr) {
+	if (n_ptr->right != nullptr)
+		return first_(n_ptr->right);
+
+	while (n_ptr->parent != nullptr && n_ptr->parent->right == n_ptr)
+		n_ptr = n_ptr->parent;
+	return n_ptr->parent;
+}
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Node * IndexedList<T, AllocT>::predecessor_(Node *n_ptr) {
+	if (n_ptr->left != nullptr)
+		return last_(n_ptr->left);
+
+	while (n_ptr->parent != nullptr && n_ptr->parent->left == n_ptr)
+		n_ptr = n_ptr->parent;
+	return n_ptr->parent;
+}
+
+
+
+template<typename T, typename AllocT>
+void IndexedList<T, AllocT>::insert(const unsigned i, const T & value) {
+	Node *l, *r;
+	split_(head_, i, l, r);
+	head_ = merge_(merge_(l, newNode_(value)), r);
+	head_->parent = nullptr;
+}
+
+template<typename T, typename AllocT>
+inline void IndexedList<T, AllocT>::remove(const unsigned i) {
+	Node *n_ptr = at_(i);
+	if (n_ptr != nullptr)
+		erase(Iterator(n_ptr, this));
+}
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Iterator IndexedList<T, AllocT>::insertBefore(Iterator pos, const T &value) {
+	unsigned i = indexOf(pos);
+	insert(i, value);
+	return Iterator(at_(i), this);
+}
+
+template<typename T, typename AllocT>
+typename IndexedList<T, AllocT>::Iterator IndexedList<T, AllocT>::erase(Iterator it) {
+	Node *toDel = it.it_;
+	Node *after = successor_(toDel);
+	Node *parent = toDel->parent;
+
+	// its children merge into its place, their priorities are still below its parent's
+	Node *child = merge_(toDel->left, toDel->right);
+	if (child != nullptr)
+		child->parent = parent;
+
+	if (parent == nullptr)
+		head_ = child;
+	else {
+		if (parent->left == toDel)
+			parent->left = child;
+		else
+			parent->right = child;
+
+		for (; parent != nullptr; parent = parent->parent)
+			--parent->count;
+	}
+
+	deleteNode_(toDel);
+	return Iterator(after, this);
+}
+
+template<typename T, typename AllocT>
+unsigned IndexedList<T, AllocT>::indexOf(Iterator it) const {
+	const Node *n_ptr = it.it_;
+	if (n_ptr == nullptr)
+		return size();
+
+	// everything left of the node, and left of every ancestor it is right of
+	unsigned index = count_(n_ptr->left);
+	for (; n_ptr->parent != nullptr; n_ptr = n_ptr->parent) {
+		if (n_ptr->parent->right == n_ptr)
+			index += count_(n_ptr->parent->left) + 1;
+	}
+	return index;
+}
+
+template<typename T, typename AllocT>
+IndexedList<T, AllocT> IndexedList<T, AllocT>::split(const unsigned i) {
+	IndexedList list(alloc_, priority_());
+
+	split_(head_, i, head_, list.head_);
+	if (head_ != nullptr)
+		head_->parent = nullptr;
+	if (list.head_ != nullptr)
+		list.head_->parent = nullptr;
+	return list;
+}
+
+template<typename T, typename AllocT>
+void IndexedList<T, AllocT>::concat(IndexedList &list) {
+	if (this == &list)
+		return;
+
+	if (alloc_ == list.alloc_) {
+		head_ = merge_(head_, list.head_);
+		list.head_ = nullptr;
+	}
+	else {
+		for (Node *n_ptr = first_(list.head_); n_ptr != nullptr; n_ptr = successor_(n_ptr))
+			head_ = merge_(head_, newNode_(n_ptr->value));
+		list.clear();
+	}
+
+	if (head_ != nullptr)
+		head_->parent = nullptr;
+}
+
+template<typename T, typename AllocT>
+inline T & IndexedList<T, AllocT>::operator[](const unsigned i) { return at_(i)->value; }
+
+template<typename T, typename AllocT>
+inline T IndexedList<T, AllocT>::operator[](const unsigned i) const { return at_(i)->value; }
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Iterator IndexedList<T, AllocT>::start() { return Iterator(first_(head_), this); }
+
+template<typename T, typename AllocT>
+inline typename IndexedList<T, AllocT>::Iterator IndexedList<T, AllocT>::end() { return Iterator(nullptr, this); }
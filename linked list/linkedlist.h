@@ -1,7 +1,16 @@
 #pragma once
+#include <functional>
 #include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "../nodepool/nodepool.h"
 
-template<typename T>
+// nodes come from AllocT rebound to the node type, a NodePool by default, std::pmr::polymorphic_allocator works too
+// splice() and merge() relink nodes between lists sharing an allocator, see makeSibling(),
+// between lists that dont, the values are moved into new nodes instead
+
+template<typename T, typename AllocT = PoolAllocator<T>>
 class List {
 protected:
 	// linked list node
@@ -9,25 +18,68 @@ protected:
 	public:
 		T value;
 		Node *next, *prev;
-		Node(const T value = T()) : value(value), next(nullptr), prev(nullptr) {}
+
+		template<typename... ArgsT>
+		Node(ArgsT&&... args) : value(std::forward<ArgsT>(args)...), next(nullptr), prev(nullptr) {}
 	};
 
+	typedef typename std::allocator_traits<AllocT>::template rebind_alloc<Node> NodeAllocT;
+	typedef std::allocator_traits<NodeAllocT> NodeTraits;
+
 public:
 	class Iterator;
 
 protected:
+	NodeAllocT alloc_;
 	Node head_, tail_;
 	unsigned size_;
 
 protected:
 	Node * at_(const unsigned index);
 
+	// allocates and constructs a node
+	template<typename... ArgsT>
+	Node * newNode_(ArgsT&&... args);
+
+	// destroys a node and gives its memory back
+	void deleteNode_(Node *node);
+
+	// empties the list without freeing its nodes, they must have been handed to another list
+	void reset_();
+
+	// moves every node of list onto this one, which must be empty, sharing its allocator
+	void take_(List &list);
+
+	// replaces nodes first up to last of list with nodes from this list's allocator holding the same values
+	// returns the new first node
+	Node * adopt_(List &list, Node *first, Node *last);
+
+	// unlinks nodes first up to last, count of them, from list and links them before pos
+	void relink_(Node *pos, List &list, Node *first, Node *last, unsigned count);
+
+	// merges two nullptr terminated runs sorted by compare, linked through next only
+	// a's nodes go first among equals
+	template<typename CompareT>
+	static Node * mergeRuns_(Node *a, Node *b, CompareT &compare);
+
+	// empty list using the given node allocator
+	explicit List(const NodeAllocT &alloc, int);
+
 public:
 	List();
-	List(List &list);
-	List(const std::initializer_list<T> &list);
+	explicit List(const AllocT &alloc);
+	List(const List &list);
+	// takes every node of list, leaving it empty, O(1)
+	List(List &&list);
+	List(const std::initializer_list<T> &list, const AllocT &alloc = AllocT());
 	~List();
 
+	List & operator=(const List &list);
+	List & operator=(List &&list);
+
+	// empty list sharing this one's allocator, so nodes move between the two by splice() and merge() in O(1)
+	List makeSibling() const;
+
 	unsigned size() const { return size_; }
 
 	// clears entire list
@@ -39,6 +91,42 @@ public:
 	// removes an element from list
 	void remove(const unsigned i);
 
+	// inserts element before the one pos points to, in constant time
+	// returns iterator to the inserted element
+	Iterator insertBefore(Iterator pos, const T &value);
+	Iterator insertBefore(Iterator pos, T &&value);
+
+	// constructs an element in place before the one pos points to, in constant time
+	// returns iterator to the inserted element
+	template<typename... ArgsT>
+	Iterator emplace(Iterator pos, ArgsT&&... args);
+
+	// removes the element it points to, in constant time
+	// returns iterator to the element after it
+	Iterator erase(Iterator it);
+
+	// moves the element it points to so it sits before the one pos points to, in constant time
+	// nothing is copied, iterators to it stay valid
+	void moveBefore(Iterator pos, Iterator it);
+
+	// moves every element of list before the one pos points to, leaving list empty, in constant time
+	void splice(Iterator pos, List &list);
+	// moves the element it of list points to before the one pos points to, in constant time
+	void splice(Iterator pos, List &list, Iterator it);
+	// moves elements first up to last of list before the one pos points to, pos must not be among them
+	// constant time within one list, otherwise the moved elements are counted, O(last - first)
+	void splice(Iterator pos, List &list, Iterator first, Iterator last);
+
+	// merges list, sorted by compare, into this sorted list, leaving list empty, O(n + list.size())
+	// elements of this list go first among equals
+	template<typename CompareT = std::less<T>>
+	void merge(List &list, CompareT compare = CompareT());
+
+	// stable merge sort, O(n log n), relinks nodes without copying or moving any value
+	// iterators stay valid and point to the same elements
+	template<typename CompareT = std::less<T>>
+	void sort(CompareT compare = CompareT());
+
 	// access an element in the list
 	T & operator[](const unsigned i);
 	// get copy of an element in the list
@@ -52,8 +140,10 @@ public:
 
 
 // Iterator for linked lists
-template<typename T>
-class List<T>::Iterator {
+template<typename T, typename AllocT>
+class List<T, AllocT>::Iterator {
+	friend class List;
+
 	protected:
 		Node *it_;
 
@@ -78,6 +168,7 @@ class List<T>::Iterator {
 		T operator*() const { return it_->value; }
 
 		Node * operator=(Node * ptr) { return this->it_ = ptr; }
+		Iterator & operator=(const Iterator &it) { it_ = it.it_; return *this; }
 
 		bool operator==(const Iterator &it) const { return this->it_ == it.it_; }
 		bool operator!=(const Iterator &it) const { return this->it_ != it.it_; }
@@ -86,27 +177,27 @@ class List<T>::Iterator {
 
 
 
-template<typename T>
-inline typename List<T>::Iterator & List<T>::Iterator::operator++() {
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator & List<T, AllocT>::Iterator::operator++() {
 	it_ = it_->next;
 	return *this;
 }
 
-template<typename T>
-inline typename List<T>::Iterator List<T>::Iterator::operator++(int) {
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator List<T, AllocT>::Iterator::operator++(int) {
 	Iterator temp = *this;
 	it_ = it_->next;
 	return temp;
 }
 
-template<typename T>
-inline typename List<T>::Iterator & List<T>::Iterator::operator--() {
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator & List<T, AllocT>::Iterator::operator--() {
 	it_ = it_->prev;
 	return *this;
 }
 
-template<typename T>
-inline typename List<T>::Iterator List<T>::Iterator::operator--(int) {
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator List<T, AllocT>::Iterator::operator--(int) {
 	Iterator temp = *this;
 	it_ = it_->prev;
 	return temp;
@@ -117,19 +208,31 @@ inline typename List<T>::Iterator List<T>::Iterator::operator--(int) {
 
 
 
-template<typename T>
-inline List<T>::List() : size_(0) {
+template<typename T, typename AllocT>
+inline List<T, AllocT>::List() : alloc_(AllocT()), size_(0) {
 	head_.next = &tail_;
 	tail_.prev = &head_;
 }
 
-template<typename T>
-List<T>::List(List & list) : size_(list.size_) {
+template<typename T, typename AllocT>
+inline List<T, AllocT>::List(const AllocT &alloc) : alloc_(alloc), size_(0) {
+	head_.next = &tail_;
+	tail_.prev = &head_;
+}
+
+template<typename T, typename AllocT>
+inline List<T, AllocT>::List(const NodeAllocT &alloc, int) : alloc_(alloc), size_(0) {
+	head_.next = &tail_;
+	tail_.prev = &head_;
+}
+
+template<typename T, typename AllocT>
+List<T, AllocT>::List(const List & list) : alloc_(NodeTraits::select_on_container_copy_construction(list.alloc_)), size_(list.size_) {
 	Node *pos = &head_;
-	Node *listIt = list.head_.next;
+	const Node *listIt = list.head_.next;
 
 	for (unsigned i = 0; i < size_; ++i) {
-		pos->next = new Node(listIt->value);
+		pos->next = newNode_(listIt->value);
 		pos->next->prev = pos;
 		pos = pos->next;
 		listIt = listIt->next;
@@ -138,12 +241,17 @@ List<T>::List(List & list) : size_(list.size_) {
 	pos->next = &tail_;
 }
 
-template<typename T>
-List<T>::List(const std::initializer_list<T> & list) : size_(list.size()) {
+template<typename T, typename AllocT>
+inline List<T, AllocT>::List(List &&list) : alloc_(list.alloc_), size_(0) {
+	take_(list);
+}
+
+template<typename T, typename AllocT>
+List<T, AllocT>::List(const std::initializer_list<T> & list, const AllocT &alloc) : alloc_(alloc), size_(list.size()) {
 	Node *pos = &head_;
 
 	for (unsigned i = 0; i < size_; ++i) {
-		pos->next = new Node(*(list.begin() + i));
+		pos->next = newNode_(*(list.begin() + i));
 		pos->next->prev = pos;
 		pos = pos->next;
 	}
@@ -153,24 +261,188 @@ List<T>::List(const std::initializer_list<T> & list) : size_(list.size()) {
 
 
 
-template<typename T>
-void List<T>::clear(){
-	Node *it = head_.next;
-	while (it != &tail_) {
-		Node *temp = it;
-		it = it->next;
-		delete temp;
+template<typename T, typename AllocT>
+void List<T, AllocT>::clear(){
+	// the allocator can drop every node at once if none need destroying
+	// unless a sibling or moved from list still uses it
+	bool released = false;
+	if constexpr (AllocatorReleases<NodeAllocT>::value && std::is_trivially_destructible<T>::value) {
+		if (!alloc_.shared()) {
+			alloc_.release();
+			released = true;
+		}
 	}
+
+	if (!released) {
+		Node *it = head_.next;
+		while (it != &tail_) {
+			Node *temp = it;
+			it = it->next;
+			deleteNode_(temp);
+		}
+	}
+	reset_();
+}
+
+template<typename T, typename AllocT>
+inline List<T, AllocT>::~List() { clear(); }
+
+template<typename T, typename AllocT>
+List<T, AllocT> & List<T, AllocT>::operator=(const List &list) {
+	if (this == &list)
+		return *this;
+
+	clear();
+	for (const Node *it = list.head_.next; it != &list.tail_; it = it->next)
+		emplace(end(), it->value);
+	return *this;
+}
+
+template<typename T, typename AllocT>
+List<T, AllocT> & List<T, AllocT>::operator=(List &&list) {
+	if (this == &list)
+		return *this;
+
+	clear();
+	if constexpr (std::is_copy_assignable<NodeAllocT>::value) {
+		alloc_ = list.alloc_;
+		take_(list);
+	}
+	else if (alloc_ == list.alloc_)
+		take_(list);
+	else {
+		// allocators like std::pmr::polymorphic_allocator stay with their list, so the values are moved instead
+		for (Node *it = list.head_.next; it != &list.tail_; it = it->next)
+			emplace(end(), std::move(it->value));
+		list.clear();
+	}
+	return *this;
+}
+
+template<typename T, typename AllocT>
+inline List<T, AllocT> List<T, AllocT>::makeSibling() const { return List(alloc_, 0); }
+
+
+
+template<typename T, typename AllocT>
+inline void List<T, AllocT>::reset_() {
+	head_.next = &tail_;
+	tail_.prev = &head_;
 	size_ = 0;
 }
 
-template<typename T>
-inline List<T>::~List() { clear(); }
+template<typename T, typename AllocT>
+void List<T, AllocT>::take_(List &list) {
+	if (list.size_ == 0) {
+		reset_();
+		return;
+	}
+
+	// the sentinels live inside each list, so the ends of the chain are relinked to ours
+	head_.next = list.head_.next;
+	head_.next->prev = &head_;
+	tail_.prev = list.tail_.prev;
+	tail_.prev->next = &tail_;
+	size_ = list.size_;
+	list.reset_();
+}
+
+template<typename T, typename AllocT>
+typename List<T, AllocT>::Node * List<T, AllocT>::adopt_(List &list, Node *first, Node *last) {
+	Node *newFirst = last;
+	Node *stop = first->prev;
+	for (Node *it = last->prev; it != stop; ) {
+		Node *copy = newNode_(std::move(it->value));
+		copy->prev = it->prev;
+		copy->next = it->next;
+		copy->prev->next = copy;
+		copy->next->prev = copy;
+
+		Node *temp = it;
+		it = it->prev;
+		list.deleteNode_(temp);
+		newFirst = copy;
+	}
+	return newFirst;
+}
+
+template<typename T, typename AllocT>
+void List<T, AllocT>::relink_(Node *pos, List &list, Node *first, Node *last, unsigned count) {
+	if (first == last || pos == first || pos == last)
+		return;
+
+	if (&list != this && alloc_ != list.alloc_)
+		first = adopt_(list, first, last);
+	Node *back = last->prev;
+
+	first->prev->next = last;
+	last->prev = first->prev;
+
+	first->prev = pos->prev;
+	back->next = pos;
+	pos->prev->next = first;
+	pos->prev = back;
+
+	list.size_ -= count;
+	size_ += count;
+}
+
+template<typename T, typename AllocT>
+template<typename CompareT>
+typename List<T, AllocT>::Node * List<T, AllocT>::mergeRuns_(Node *a, Node *b, CompareT &compare) {
+	Node *run = nullptr;
+	Node **link = &run;
+
+	while (a != nullptr && b != nullptr) {
+		if (compare(b->value, a->value)) {
+			*link = b;
+			b = b->next;
+		}
+		else {
+			*link = a;
+			a = a->next;
+		}
+		link = &(*link)->next;
+	}
+	*link = (a != nullptr) ? a : b;
+	return run;
+}
+
+
 
+template<typename T, typename AllocT>
+template<typename... ArgsT>
+inline typename List<T, AllocT>::Node * List<T, AllocT>::newNode_(ArgsT&&... args) {
+	Node *node = NodeTraits::allocate(alloc_, 1);
+	try {
+		NodeTraits::construct(alloc_, node, std::forward<ArgsT>(args)...);
+	}
+	catch (...) {
+		NodeTraits::deallocate(alloc_, node, 1);
+		throw;
+	}
+	return node;
+}
 
+template<typename T, typename AllocT>
+inline void List<T, AllocT>::deleteNode_(Node *node) {
+	NodeTraits::destroy(alloc_, node);
+	NodeTraits::deallocate(alloc_, node, 1);
+}
+
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Node * List<T, AllocT>::at_(const unsigned index) {
+	if (index >= size_)
+		return &tail_;
+
+	// walk from whichever end is closer
+	if (index > size_ / 2) {
+		Node *temp = tail_.prev;
+		for (unsigned i = size_ - 1; i > index; i--)
+			temp = temp->prev;
+		return temp;
+	}
 
-template<typename T>
-inline typename List<T>::Node * List<T>::at_(const unsigned index) {
 	Node *temp = head_.next;
 	for (unsigned i = 0; i < index && i < size_; i++)
 		temp = temp->next;
@@ -178,10 +450,31 @@ inline typename List<T>::Node * List<T>::at_(const unsigned index) {
 }
 
 
-template<typename T>
-void List<T>::insert(const unsigned i, const T & value) {
-	Node * insertBefore = at_(i);
-	Node * toInsert = new Node(value);
+template<typename T, typename AllocT>
+inline void List<T, AllocT>::insert(const unsigned i, const T & value) {
+	insertBefore(at_(i), value);
+}
+
+template<typename T, typename AllocT>
+inline void List<T, AllocT>::remove(const unsigned i) {
+	erase(at_(i));
+}
+
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator List<T, AllocT>::insertBefore(Iterator pos, const T &value) {
+	return emplace(pos, value);
+}
+
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator List<T, AllocT>::insertBefore(Iterator pos, T &&value) {
+	return emplace(pos, std::move(value));
+}
+
+template<typename T, typename AllocT>
+template<typename... ArgsT>
+typename List<T, AllocT>::Iterator List<T, AllocT>::emplace(Iterator pos, ArgsT&&... args) {
+	Node * insertBefore = pos.it_;
+	Node * toInsert = newNode_(std::forward<ArgsT>(args)...);
 
 	toInsert->next = insertBefore;
 	toInsert->prev = insertBefore->prev;
@@ -190,28 +483,153 @@ void List<T>::insert(const unsigned i, const T & value) {
 	toInsert->prev->next = toInsert;
 
 	++size_;
+	return toInsert;
 }
 
-template<typename T>
-void List<T>::remove(const unsigned i) {
-	Node * toDel = at_(i);
+template<typename T, typename AllocT>
+typename List<T, AllocT>::Iterator List<T, AllocT>::erase(Iterator it) {
+	Node * toDel = it.it_;
+	Node * after = toDel->next;
 
 	toDel->prev->next = toDel->next;
 	toDel->next->prev = toDel->prev;
 
-	delete toDel;
+	deleteNode_(toDel);
 
 	--size_;
+	return after;
+}
+
+template<typename T, typename AllocT>
+void List<T, AllocT>::moveBefore(Iterator pos, Iterator it) {
+	Node * toMove = it.it_;
+	Node * insertBefore = pos.it_;
+	if (toMove == insertBefore || toMove->next == insertBefore)
+		return;
+
+	toMove->prev->next = toMove->next;
+	toMove->next->prev = toMove->prev;
+
+	toMove->next = insertBefore;
+	toMove->prev = insertBefore->prev;
+
+	toMove->next->prev = toMove;
+	toMove->prev->next = toMove;
+}
+
+template<typename T, typename AllocT>
+inline void List<T, AllocT>::splice(Iterator pos, List &list) {
+	if (&list != this)
+		relink_(pos.it_, list, list.head_.next, &list.tail_, list.size_);
+}
+
+template<typename T, typename AllocT>
+inline void List<T, AllocT>::splice(Iterator pos, List &list, Iterator it) {
+	relink_(pos.it_, list, it.it_, it.it_->next, 1);
+}
+
+template<typename T, typename AllocT>
+void List<T, AllocT>::splice(Iterator pos, List &list, Iterator first, Iterator last) {
+	unsigned count = 0;
+	if (&list != this) {
+		for (Node *it = first.it_; it != last.it_; it = it->next)
+			count++;
+	}
+	relink_(pos.it_, list, first.it_, last.it_, count);
+}
+
+template<typename T, typename AllocT>
+template<typename CompareT>
+void List<T, AllocT>::merge(List &list, CompareT compare) {
+	if (&list == this || list.size_ == 0)
+		return;
+
+	// moving the values over first leaves every node of list ours, so relink_ wont copy them again
+	if (alloc_ != list.alloc_) {
+		List temp = makeSibling();
+		for (Node *it = list.head_.next; it != &list.tail_; it = it->next)
+			temp.emplace(temp.end(), std::move(it->value));
+		list.clear();
+		merge(temp, compare);
+		return;
+	}
+
+	Node *b = list.head_.next;
+	Node *a = head_.next;
+
+	// each run of list's nodes smaller than a is moved before a in one relink
+	while (b != &list.tail_) {
+		while (a != &tail_ && !compare(b->value, a->value))
+			a = a->next;
+		if (a == &tail_) {
+			relink_(a, list, b, &list.tail_, 0);
+			break;
+		}
+
+		Node *runEnd = b->next;
+		while (runEnd != &list.tail_ && compare(runEnd->value, a->value))
+			runEnd = runEnd->next;
+		relink_(a, list, b, runEnd, 0);
+		b = runEnd;
+	}
+
+	size_ += list.size_;
+	list.reset_();
+}
+
+template<typename T, typename AllocT>
+template<typename CompareT>
+void List<T, AllocT>::sort(CompareT compare) {
+	if (size_ < 2)
+		return;
+
+	// bins[i] is empty or a sorted run of 2^i nodes, made of nodes earlier than those of every lower bin
+	// each node is merged up through the filled bins like a carry, so no run is ever much longer than another
+	Node *bins[sizeof(unsigned) * 8 + 1] = {};
+	unsigned filled = 0;
+
+	tail_.prev->next = nullptr;
+	Node *chain = head_.next;
+	while (chain != nullptr) {
+		Node *run = chain;
+		chain = chain->next;
+		run->next = nullptr;
+
+		unsigned i = 0;
+		for (; i < filled && bins[i] != nullptr; i++) {
+			run = mergeRuns_(bins[i], run, compare);
+			bins[i] = nullptr;
+		}
+		if (i == filled)
+			filled++;
+		bins[i] = run;
+	}
+
+	Node *sorted = nullptr;
+	for (unsigned i = 0; i < filled; i++) {
+		if (bins[i] != nullptr)
+			sorted = (sorted == nullptr) ? bins[i] : mergeRuns_(bins[i], sorted, compare);
+	}
+
+	// sorting only followed next, prev links are rebuilt in one pass
+	Node *prev = &head_;
+	for (Node *it = sorted; it != nullptr; it = it->next) {
+		it->prev = prev;
+		prev->next = it;
+		prev = it;
+	}
+	prev->next = &tail_;
+	tail_.prev = prev;
 }
 
-template<typename T>
-inline T & List<T>::operator[](const unsigned i) { return at_(i)->value; }
+template<typename T, typename AllocT>
+inline T & List<T, AllocT>::operator[](const unsigned i) { return at_(i)->value; }
 
-template<typename T>
-inline T List<T>::operator[](const unsigned i) const { return at_(i)->value; }
+template<typename T, typename AllocT>
+inline T List<T, AllocT>::operator[](const unsigned i) const { return at_(i)->value; }
 
-template<typename T>
-inline typename List<T>::Iterator List<T>::start() { return head_.next; }
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator List<T, AllocT>::start() { return head_.next; }
 
-template<typename T>
-inline typename List<T>::Iterator List<T>::end() { return &tail_; }
\ No newline at end of file
+template<typename T, typename AllocT>
+inline typename List<T, AllocT>::Iterator List<T, AllocT>::end() { return &tail_; }
\ No newline at end of file
@@ -0,0 +1,360 @@
+#pragma once
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "../nodepool/nodepool.h"
+
+// Unrolled Linked List
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// a linked list of chunks, each holding an array of up to ChunkSize elements
+// iterating reads elements next to each other instead of chasing a pointer per element,
+// seeking an index skips whole chunks, and small elements arent outweighed by their links
+// a full chunk splits in two on insert, and a chunk merges with its neighbour on remove once both fit in one
+// unlike List, inserting or removing moves the elements after it in the same chunk, invalidating iterators to them
+//
+// chunks come from AllocT rebound to the chunk type, a NodePool by default
+
+#define UNROLLED_LIST_CHUNK_BYTES 64 // size of each chunk's array of elements when ChunkSize isnt given, a cache line
+#define UNROLLED_LIST_MIN_CHUNK 4    // fewest elements a chunk holds when ChunkSize isnt given, for large elements
+
+template<typename T,
+	unsigned ChunkSize = (UNROLLED_LIST_CHUNK_BYTES / sizeof(T) > UNROLLED_LIST_MIN_CHUNK) ? UNROLLED_LIST_CHUNK_BYTES / sizeof(T) : UNROLLED_LIST_MIN_CHUNK,
+	typename AllocT = PoolAllocator<T>>
+class UnrolledList {
+	static_assert(ChunkSize >= 2, "chunks must hold at least 2 elements to be split");
+
+protected:
+	// linked list chunk, elements 0 through count - 1 of its array are constructed
+	class Chunk {
+	public:
+		Chunk *next, *prev;
+		unsigned count;
+		alignas(T) unsigned char storage[sizeof(T) * ChunkSize];
+
+		Chunk() : next(nullptr), prev(nullptr), count(0) {}
+
+		T * values() { return reinterpret_cast<T *>(storage); }
+	};
+
+	typedef typename std::allocator_traits<AllocT>::template rebind_alloc<Chunk> ChunkAllocT;
+	typedef std::allocator_traits<ChunkAllocT> ChunkTraits;
+
+public:
+	class Iterator;
+
+protected:
+	ChunkAllocT alloc_;
+	Chunk head_, tail_; // empty sentinels
+	unsigned size_;
+
+protected:
+	// chunk holding element index, with its position in the chunk written to offset
+	// index size_ gives the position just past the last element, tail_ if the list is empty
+	// starts from whichever end is closer
+	Chunk * seek_(unsigned index, unsigned &offset) const;
+
+	// allocates an empty chunk and links it after prev
+	Chunk * newChunk_(Chunk *prev);
+
+	// destroys a chunk's elements, unlinks it and gives its memory back
+	void deleteChunk_(Chunk *chunk);
+
+	// moves the upper half of a full chunk into a new chunk after it
+	void split_(Chunk *chunk);
+
+	// moves every element of next to the end of chunk and deletes next
+	void merge_(Chunk *chunk, Chunk *next);
+
+public:
+	UnrolledList();
+	explicit UnrolledList(const AllocT &alloc);
+	UnrolledList(const UnrolledList &list);
+	UnrolledList(const std::initializer_list<T> &list, const AllocT &alloc = AllocT());
+	~UnrolledList();
+
+	UnrolledList & operator=(const UnrolledList &list) = delete;
+
+	unsigned size() const { return size_; }
+
+	// clears entire list
+	void clear();
+
+	// inserts element at given position, pushes rest of the list forward
+	void insert(const unsigned i, const T & value);
+
+	// removes an element from list
+	void remove(const unsigned i);
+
+	// access an element in the list
+	T & operator[](const unsigned i);
+	// get copy of an element in the list
+	T operator[](const unsigned i) const;
+
+	// iterator pointing to first element of list
+	Iterator start();
+	// iterator pointing to end + 1 of list
+	Iterator end();
+};
+
+
+// Iterator for unrolled lists
+template<typename T, unsigned ChunkSize, typename AllocT>
+class UnrolledList<T, ChunkSize, AllocT>::Iterator {
+	friend class UnrolledList;
+
+	protected:
+		Chunk *chunk_;
+		unsigned i_; // position in chunk
+
+	public:
+		Iterator() : chunk_(nullptr), i_(0) {}
+		Iterator(Chunk *chunk, unsigned i) : chunk_(chunk), i_(i) {}
+
+		// advance iterator
+		Iterator next() const { return (i_ + 1 < chunk_->count) ? Iterator(chunk_, i_ + 1) : Iterator(chunk_->next, 0); }
+		// move iterator back
+		Iterator prev() const { return (i_ > 0) ? Iterator(chunk_, i_ - 1) : Iterator(chunk_->prev, chunk_->prev->count - 1); }
+
+		Iterator & operator++() { return *this = next(); }
+		Iterator operator++(int) { Iterator temp = *this; *this = next(); return temp; }
+
+		Iterator & operator--() { return *this = prev(); }
+		Iterator operator--(int) { Iterator temp = *this; *this = prev(); return temp; }
+
+		// dereferance iterator
+		T & operator*() { return chunk_->values()[i_]; }
+		T operator*() const { return chunk_->values()[i_]; }
+
+		bool operator==(const Iterator &it) const { return chunk_ == it.chunk_ && i_ == it.i_; }
+		bool operator!=(const Iterator &it) const { return !(*this == it); }
+};
+
+
+
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline UnrolledList<T, ChunkSize, AllocT>::UnrolledList() : alloc_(AllocT()), size_(0) {
+	head_.next = &tail_;
+	tail_.prev = &head_;
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline UnrolledList<T, ChunkSize, AllocT>::UnrolledList(const AllocT &alloc) : alloc_(alloc), size_(0) {
+	head_.next = &tail_;
+	tail_.prev = &head_;
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+UnrolledList<T, ChunkSize, AllocT>::UnrolledList(const UnrolledList &list)
+	: alloc_(ChunkTraits::select_on_container_copy_construction(list.alloc_)), size_(list.size_) {
+	head_.next = &tail_;
+	tail_.prev = &head_;
+
+	for (Chunk *from = list.head_.next; from != &list.tail_; from = from->next) {
+		Chunk *chunk = newChunk_(tail_.prev);
+		for (; chunk->count < from->count; chunk->count++)
+			new (chunk->values() + chunk->count) T(from->values()[chunk->count]);
+	}
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+UnrolledList<T, ChunkSize, AllocT>::UnrolledList(const std::initializer_list<T> &list, const AllocT &alloc) : alloc_(alloc), size_(0) {
+	head_.next = &tail_;
+	tail_.prev = &head_;
+
+	// fills chunks completely, the same as a copy of a list that was only ever appended to
+	Chunk *chunk = &head_;
+	for (const T &value : list) {
+		if (chunk->count == ChunkSize || chunk == &head_)
+			chunk = newChunk_(chunk);
+		new (chunk->values() + chunk->count++) T(value);
+		++size_;
+	}
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+void UnrolledList<T, ChunkSize, AllocT>::clear() {
+	// the allocator can drop every chunk at once if no elements need destroying
+	// unless another list made with the same allocator takes its chunks from it too
+	bool released = false;
+	if constexpr (AllocatorReleases<ChunkAllocT>::value && std::is_trivially_destructible<T>::value) {
+		if (!alloc_.shared()) {
+			alloc_.release();
+			released = true;
+		}
+	}
+
+	if (!released) {
+		while (head_.next != &tail_)
+			deleteChunk_(head_.next);
+	}
+	head_.next = &tail_;
+	tail_.prev = &head_;
+	size_ = 0;
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline UnrolledList<T, ChunkSize, AllocT>::~UnrolledList() { clear(); }
+
+
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+typename UnrolledList<T, ChunkSize, AllocT>::Chunk * UnrolledList<T, ChunkSize, AllocT>::newChunk_(Chunk *prev) {
+	Chunk *chunk = ChunkTraits::allocate(alloc_, 1);
+	ChunkTraits::construct(alloc_, chunk);
+
+	chunk->prev = prev;
+	chunk->next = prev->next;
+	chunk->next->prev = chunk;
+	prev->next = chunk;
+	return chunk;
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+void UnrolledList<T, ChunkSize, AllocT>::deleteChunk_(Chunk *chunk) {
+	for (unsigned i = 0; i < chunk->count; i++)
+		chunk->values()[i].~T();
+
+	chunk->prev->next = chunk->next;
+	chunk->next->prev = chunk->prev;
+
+	ChunkTraits::destroy(alloc_, chunk);
+	ChunkTraits::deallocate(alloc_, chunk, 1);
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+void UnrolledList<T, ChunkSize, AllocT>::split_(Chunk *chunk) {
+	Chunk *upper = newChunk_(chunk);
+	T *from = chunk->values();
+	unsigned half = chunk->count / 2;
+
+	for (unsigned i = half; i < chunk->count; i++) {
+		new (upper->values() + upper->count++) T(std::move(from[i]));
+		from[i].~T();
+	}
+	chunk->count = half;
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+void UnrolledList<T, ChunkSize, AllocT>::merge_(Chunk *chunk, Chunk *next) {
+	T *from = next->values();
+
+	for (unsigned i = 0; i < next->count; i++) {
+		new (chunk->values() + chunk->count++) T(std::move(from[i]));
+		from[i].~T();
+	}
+	next->count = 0;
+	deleteChunk_(next);
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+typename UnrolledList<T, ChunkSize, AllocT>::Chunk * UnrolledList<T, ChunkSize, AllocT>::seek_(unsigned index, unsigned &offset) const {
+	if (index > size_)
+		index = size_;
+
+	Chunk *chunk;
+	if (index <= size_ / 2) {
+		// the end of an empty list is tail_
+		chunk = head_.next;
+		while (chunk != &tail_ && index >= chunk->count) {
+			index -= chunk->count;
+			chunk = chunk->next;
+		}
+	}
+	else {
+		// count back from the end, index becomes the number of elements from the chunk's start to the end
+		index = size_ - index;
+		chunk = tail_.prev;
+		while (index > chunk->count) {
+			index -= chunk->count;
+			chunk = chunk->prev;
+		}
+		index = chunk->count - index;
+	}
+
+	offset = index;
+	return chunk;
+}
+
+
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+void UnrolledList<T, ChunkSize, AllocT>::insert(const unsigned i, const T & value) {
+	// value may be an element of this list, which splitting or shifting would move out from under it
+	T copy(value);
+
+	unsigned offset;
+	Chunk *chunk = seek_(i, offset);
+
+	if (chunk == &tail_)
+		chunk = newChunk_(&head_);
+	else if (chunk->count == ChunkSize) {
+		split_(chunk);
+		if (offset > chunk->count) {
+			offset -= chunk->count;
+			chunk = chunk->next;
+		}
+	}
+
+	// shift everything after offset up one
+	T *values = chunk->values();
+	if (offset == chunk->count)
+		new (values + offset) T(std::move(copy));
+	else {
+		new (values + chunk->count) T(std::move(values[chunk->count - 1]));
+		for (unsigned k = chunk->count - 1; k > offset; k--)
+			values[k] = std::move(values[k - 1]);
+		values[offset] = std::move(copy);
+	}
+
+	++chunk->count;
+	++size_;
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+void UnrolledList<T, ChunkSize, AllocT>::remove(const unsigned i) {
+	if (i >= size_)
+		return;
+
+	unsigned offset;
+	Chunk *chunk = seek_(i, offset);
+
+	// shift everything after offset down one
+	T *values = chunk->values();
+	for (unsigned k = offset; k + 1 < chunk->count; k++)
+		values[k] = std::move(values[k + 1]);
+	values[--chunk->count].~T();
+	--size_;
+
+	if (chunk->count == 0) {
+		deleteChunk_(chunk);
+		return;
+	}
+
+	// merge with a neighbour once both fit in one chunk, keeping chunks half full on average
+	if (chunk->next != &tail_ && chunk->count + chunk->next->count <= ChunkSize)
+		merge_(chunk, chunk->next);
+	else if (chunk->prev != &head_ && chunk->prev->count + chunk->count <= ChunkSize)
+		merge_(chunk->prev, chunk);
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline T & UnrolledList<T, ChunkSize, AllocT>::operator[](const unsigned i) {
+	unsigned offset;
+	return seek_(i, offset)->values()[offset];
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline T UnrolledList<T, ChunkSize, AllocT>::operator[](const unsigned i) const {
+	unsigned offset;
+	return seek_(i, offset)->values()[offset];
+}
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline typename UnrolledList<T, ChunkSize, AllocT>::Iterator UnrolledList<T, ChunkSize, AllocT>::start() { return Iterator(head_.next, 0); }
+
+template<typename T, unsigned ChunkSize, typename AllocT>
+inline typename UnrolledList<T, ChunkSize, AllocT>::Iterator UnrolledList<T, ChunkSize, AllocT>::end() { return Iterator(&tail_, 0); }
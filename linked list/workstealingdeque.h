@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// Work Stealing Deque
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// a deque owned by one thread, which pushes and pops at the bottom like a stack,
+// while any other thread can steal from the top without locks (Chase and Lev)
+// the owner only contends with thieves when one element is left
+//
+// elements live in a circular array that the owner doubles when full. thieves may still be reading an old
+// array after it is replaced, so old arrays are kept until the deque is destroyed, which never takes more
+// than the final array again
+// a thief reads its element before knowing whether it won it, so elements must be trivially copyable,
+// pointers or indices of tasks for example
+
+#define WORK_STEALING_DEQUE_BASIC_SIZE 64 // starting capacity of a deque, must be a power of 2
+
+template<typename T>
+class WorkStealingDeque {
+	static_assert(std::is_trivially_copyable<T>::value, "thieves copy elements they may lose, T must be trivially copyable");
+
+protected:
+	// circular array of elements, indexed by position modulo its size
+	struct Array {
+		std::int64_t size;
+		Array *previous; // array this one replaced
+		std::atomic<T> *values;
+
+		Array(std::int64_t size, Array *previous) : size(size), previous(previous), values(new std::atomic<T>[size]) {}
+		~Array() { delete[] values; }
+
+		T get(std::int64_t i) const { return values[i & (size - 1)].load(std::memory_order_relaxed); }
+		void put(std::int64_t i, const T &value) { values[i & (size - 1)].store(value, std::memory_order_relaxed); }
+	};
+
+protected:
+	alignas(64) std::atomic<std::int64_t> top_;    // position of the next steal
+	alignas(64) std::atomic<std::int64_t> bottom_; // position of the next push, only written by the owner
+	std::atomic<Array *> array_;
+
+protected:
+	// copies elements top through bottom into an array twice as large, and makes it the current one
+	Array * grow_(Array *array, std::int64_t top, std::int64_t bottom);
+
+public:
+	// creates an empty deque, capacity is rounded up to a power of 2
+	explicit WorkStealingDeque(unsigned capacity = WORK_STEALING_DEQUE_BASIC_SIZE);
+
+	WorkStealingDeque(const WorkStealingDeque &deque) = delete;
+	WorkStealingDeque & operator=(const WorkStealingDeque &deque) = delete;
+
+	~WorkStealingDeque();
+
+	// adds an element to the bottom, owner only
+	void push(const T &value);
+
+	// removes the bottom element, the one pushed last, owner only
+	// false if the deque was empty
+	bool tryPop(T &out);
+
+	// removes the top element, the one pushed first, from any thread
+	// false if the deque was empty or another thread took the element first
+	bool trySteal(T &out);
+
+	// number of elements when checked, other threads may have changed it since
+	unsigned size() const;
+
+	// true if the deque was empty when checked
+	bool empty() const { return size() == 0; }
+};
+
+
+
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(unsigned capacity) : top_(0), bottom_(0) {
+	std::int64_t size = 2;
+	while (size < capacity)
+		size *= 2;
+	array_.store(new Array(size, nullptr), std::memory_order_relaxed);
+}
+
+template<typename T>
+WorkStealingDeque<T>::~WorkStealingDeque() {
+	Array *array = array_.load(std::memory_order_relaxed);
+	while (array != nullptr) {
+		Array *temp = array;
+		array = array->previous;
+		delete temp;
+	}
+}
+
+
+
+template<typename T>
+typename WorkStealingDeque<T>::Array * WorkStealingDeque<T>::grow_(Array *array, std::int64_t top, std::int64_t bottom) {
+	Array *bigger = new Array(array->size * 2, array);
+	for (std::int64_t i = top; i < bottom; i++)
+		bigger->put(i, array->get(i));
+
+	array_.store(bigger, std::memory_order_release);
+	return bigger;
+}
+
+template<typename T>
+void WorkStealingDeque<T>::push(const T &value) {
+	std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+	std::int64_t top = top_.load(std::memory_order_acquire);
+	Array *array = array_.load(std::memory_order_relaxed);
+
+	if (bottom - top > array->size - 1)
+		array = grow_(array, top, bottom);
+
+	array->put(bottom, value);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom_.store(bottom + 1, std::memory_order_relaxed);
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::tryPop(T &out) {
+	// claim the bottom element first, so thieves see it is gone before top_ is read
+	std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+	Array *array = array_.load(std::memory_order_relaxed);
+	bottom_.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t top = top_.load(std::memory_order_relaxed);
+
+	if (top > bottom) {
+		bottom_.store(bottom + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	out = array->get(bottom);
+	if (top == bottom) {
+		// last element, race the thieves for it
+		bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		bottom_.store(bottom + 1, std::memory_order_relaxed);
+		return won;
+	}
+	return true;
+}
+
+template<typename T>
+bool WorkStealingDeque<T>::trySteal(T &out) {
+	std::int64_t top = top_.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+		return false;
+
+	Array *array = array_.load(std::memory_order_acquire);
+	T value = array->get(top);
+	if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return false;
+
+	out = value;
+	return true;
+}
+
+template<typename T>
+unsigned WorkStealingDeque<T>::size() const {
+	std::int64_t top = top_.load(std::memory_order_relaxed);
+	std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+	return (bottom > top) ? (unsigned)(bottom - top) : 0;
+}
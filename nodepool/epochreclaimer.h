@@ -0,0 +1,199 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Epoch Based Reclaimer
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// decides when a node unlinked from a lock free structure can be freed, since other threads may still be reading it
+// every operation pins itself to the current epoch while it touches nodes, and unlinked nodes are retired
+// into the list of the epoch current when they were unlinked. the epoch only moves forward once every pinned
+// operation has seen it, so after it has moved twice nobody pinned early enough to hold those nodes is left,
+// and that list is handed back to be freed
+//
+// pinning takes a record from a list shared by all threads instead of a thread_local slot,
+// so there are only ever as many records as operations that ran at once
+// NodeT must have a NodeT *retiredNext member, unused by the structure itself, to link retired nodes
+
+#define EPOCH_RECLAIMER_INTERVAL 64 // retires between attempts to move the epoch forward
+
+template<typename NodeT>
+class EpochReclaimer {
+protected:
+	static const std::uint64_t Idle = ~std::uint64_t(0);
+
+	// slot announcing the epoch an operation is pinned to, on its own cache line
+	struct alignas(64) Record {
+		std::atomic<std::uint64_t> epoch; // Idle while the record is not pinned
+		std::atomic<bool> taken;
+		Record *next;
+		unsigned retires; // retires since the last attempt to move the epoch, only touched by the record's holder
+
+		Record() : epoch(Idle), taken(true), next(nullptr), retires(0) {}
+	};
+
+public:
+	// keeps an operation pinned for as long as it lives
+	class Guard {
+		friend class EpochReclaimer;
+
+		protected:
+			Record *record_;
+
+			Guard(Record *record) : record_(record) {}
+
+		public:
+			Guard(const Guard &guard) = delete;
+			Guard & operator=(const Guard &guard) = delete;
+			~Guard();
+	};
+
+public:
+	EpochReclaimer();
+
+	EpochReclaimer(const EpochReclaimer &reclaimer) = delete;
+	EpochReclaimer & operator=(const EpochReclaimer &reclaimer) = delete;
+
+	// frees the records, retired nodes must be taken with drain() first
+	~EpochReclaimer();
+
+	// pins the calling operation to the current epoch
+	Guard pin();
+
+	// hands over a node already unlinked from the structure
+	// returns nodes that are now safe to free, linked through retiredNext, or nullptr
+	NodeT * retire(Guard &guard, NodeT *node);
+
+	// every retired node, linked through retiredNext, no operation may be running
+	NodeT * drain();
+
+protected:
+	std::atomic<std::uint64_t> epoch_;
+
+	// every record made, records are reused but never freed before the reclaimer
+	std::atomic<Record *> records_;
+
+	// nodes retired in each epoch, by epoch % 3
+	std::atomic<NodeT *> retired_[3];
+
+protected:
+	// moves the epoch forward if every pinned operation has seen it, the caller must be pinned
+	// returns the nodes retired two epochs before the new one, or nullptr
+	NodeT * tryAdvance_();
+
+	// appends list b to list a, returns the combined list
+	static NodeT * append_(NodeT *a, NodeT *b);
+};
+
+
+
+template<typename NodeT>
+inline EpochReclaimer<NodeT>::Guard::~Guard() {
+	record_->epoch.store(Idle);
+	record_->taken.store(false, std::memory_order_release);
+}
+
+template<typename NodeT>
+EpochReclaimer<NodeT>::EpochReclaimer() : epoch_(0), records_(nullptr) {
+	for (unsigned i = 0; i < 3; i++)
+		retired_[i].store(nullptr, std::memory_order_relaxed);
+}
+
+template<typename NodeT>
+EpochReclaimer<NodeT>::~EpochReclaimer() {
+	Record *r = records_.load(std::memory_order_relaxed);
+	while (r != nullptr) {
+		Record *temp = r;
+		r = r->next;
+		delete temp;
+	}
+}
+
+
+
+template<typename NodeT>
+typename EpochReclaimer<NodeT>::Guard EpochReclaimer<NodeT>::pin() {
+	Record *record = nullptr;
+
+	for (Record *r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+		bool expected = false;
+		if (!r->taken.load(std::memory_order_relaxed) && r->taken.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+			record = r;
+			break;
+		}
+	}
+
+	// every record is in use, add another
+	if (record == nullptr) {
+		record = new Record();
+		Record *head = records_.load(std::memory_order_relaxed);
+		do {
+			record->next = head;
+		} while (!records_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// announce the epoch, then make sure it didnt move before the announcement could be seen
+	std::uint64_t e = epoch_.load();
+	for (;;) {
+		record->epoch.store(e);
+		std::uint64_t now = epoch_.load();
+		if (now == e)
+			break;
+		e = now;
+	}
+	return Guard(record);
+}
+
+template<typename NodeT>
+NodeT * EpochReclaimer<NodeT>::retire(Guard &guard, NodeT *node) {
+	// any operation that could still reach the node is pinned to this epoch or an earlier one
+	std::atomic<NodeT *> &list = retired_[epoch_.load() % 3];
+
+	NodeT *head = list.load(std::memory_order_relaxed);
+	do {
+		node->retiredNext = head;
+	} while (!list.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+	if (++guard.record_->retires < EPOCH_RECLAIMER_INTERVAL)
+		return nullptr;
+	guard.record_->retires = 0;
+	return tryAdvance_();
+}
+
+template<typename NodeT>
+NodeT * EpochReclaimer<NodeT>::drain() {
+	NodeT *all = nullptr;
+	for (unsigned i = 0; i < 3; i++)
+		all = append_(all, retired_[i].exchange(nullptr, std::memory_order_acquire));
+	return all;
+}
+
+template<typename NodeT>
+NodeT * EpochReclaimer<NodeT>::tryAdvance_() {
+	std::uint64_t e = epoch_.load();
+
+	for (Record *r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+		std::uint64_t announced = r->epoch.load();
+		if (announced != Idle && announced != e)
+			return nullptr;
+	}
+
+	if (!epoch_.compare_exchange_strong(e, e + 1))
+		return nullptr;
+
+	// its nodes were retired in e - 1, and every operation pinned then or earlier has since finished
+	// the caller is still pinned to e, so the epoch cant move again and refill this list before it is taken
+	return retired_[(e + 2) % 3].exchange(nullptr, std::memory_order_acquire);
+}
+
+template<typename NodeT>
+NodeT * EpochReclaimer<NodeT>::append_(NodeT *a, NodeT *b) {
+	if (a == nullptr)
+		return b;
+
+	NodeT *last = a;
+	while (last->retiredNext != nullptr)
+		last = last->retiredNext;
+	last->retiredNext = b;
+	return a;
+}
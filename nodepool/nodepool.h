@@ -0,0 +1,315 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A pool of fixed size nodes, carved out of large slabs
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// nodes are handed out uninitialized, the user constructs and destroys the objects in them
+// freed nodes go onto a free list and are reused before anything new is carved out
+// every new slab is twice as large as the previous one, so holding n nodes takes O(log n) allocations
+
+#define NODEPOOL_FIRST_SLAB_SIZE 32 // number of nodes in the first slab a pool allocates
+
+template<typename T>
+class NodePool {
+protected:
+	// storage for a single node, links to the next free node while unused
+	union Slot {
+		Slot *next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	// header at the start of every slab, slabs form a list so they can all be released
+	struct Slab {
+		Slab *next;
+		std::size_t size;
+	};
+
+public:
+	NodePool();
+
+	NodePool(const NodePool &pool) = delete;
+	NodePool & operator=(const NodePool &pool) = delete;
+
+	~NodePool();
+
+	// memory for one node, does not construct it
+	T * allocate();
+
+	// returns a node's memory to the pool, its object must already be destroyed
+	void deallocate(T *node);
+
+	// makes sure at least the given number of nodes can be allocated without allocating another slab
+	void reserve(std::size_t nodes);
+
+	// releases every slab at once
+	// all nodes given out are invalidated, their objects must be destroyed beforehand unless trivially destructible
+	void clear();
+
+	// swaps the contents of two pools, nodes stay valid and now belong to the other pool
+	void swap(NodePool &pool);
+
+	// number of nodes the pool can hand out without allocating another slab
+	std::size_t available() const;
+
+	// number of slabs allocated
+	std::size_t slabs() const;
+
+protected:
+	// every slab allocated, newest first
+	Slab *slabs_;
+	std::size_t slabCount_;
+
+	// nodes that have been freed
+	Slot *freeList_;
+	std::size_t freeCount_;
+
+	// part of the newest slab that has never been handed out
+	Slot *unused_, *unusedEnd_;
+
+	// size of the next slab
+	std::size_t nextSlabSize_;
+
+protected:
+	// allocates a new slab with room for the given number of nodes, and makes it the unused area
+	// what was left of the previous unused area is moved onto the free list
+	void addSlab_(std::size_t size);
+
+	// bytes taken by a slab's header, padded so its slots stay aligned
+	static std::size_t headerSize_() { return (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot); }
+
+	// first slot in a slab, placed after the header
+	static Slot * slots_(Slab *slab) { return reinterpret_cast<Slot *>(reinterpret_cast<unsigned char *>(slab) + headerSize_()); }
+};
+
+
+// storage with the size and alignment of an object, objects with the same layout share a pool of these
+template<std::size_t Size, std::size_t Align>
+struct alignas(Align) PoolBytes {
+	unsigned char bytes[Size];
+};
+
+// every pool of a PoolAllocator and the allocators rebound from it, one per object size and alignment
+class PoolAllocatorPools {
+protected:
+	struct Entry {
+		std::size_t size, align;
+		void *pool;
+		void (*destroy)(void *pool);
+	};
+
+	// few types are ever rebound to, so a list is searched
+	std::vector<Entry> pools_;
+
+public:
+	PoolAllocatorPools() {}
+
+	PoolAllocatorPools(const PoolAllocatorPools &pools) = delete;
+	PoolAllocatorPools & operator=(const PoolAllocatorPools &pools) = delete;
+
+	~PoolAllocatorPools();
+
+	// pool for objects of the given size and alignment, made the first time it is asked for
+	template<std::size_t Size, std::size_t Align>
+	NodePool<PoolBytes<Size, Align>> * pool();
+};
+
+
+// standard allocator giving out single objects from a NodePool, for node based containers
+// copies share their pools, and so do allocators rebound to another type, as containers do to allocate
+// their nodes, so rebinding back gives an allocator equal to the original that can free its objects
+// arrays of more than one object go straight to operator new
+// not thread safe, like NodePool
+template<typename T>
+class PoolAllocator {
+	template<typename U> friend class PoolAllocator;
+
+public:
+	typedef T value_type;
+
+	PoolAllocator() : pools_(std::make_shared<PoolAllocatorPools>()), pool_(pools_->pool<sizeof(T), alignof(T)>()) {}
+	PoolAllocator(const PoolAllocator &alloc) = default;
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U> &alloc) : pools_(alloc.pools_), pool_(pools_->pool<sizeof(T), alignof(T)>()) {}
+
+	T * allocate(std::size_t n);
+	void deallocate(T *p, std::size_t n);
+
+	// a copied container gets pools of its own
+	PoolAllocator select_on_container_copy_construction() const { return PoolAllocator(); }
+
+	// releases every slab of the pool objects of this type come from at once
+	// every object from it must already be destroyed, unless trivially destructible
+	void release() { pool_->clear(); }
+
+	// true if another allocator, and so maybe another container, gives out objects from the same pools
+	bool shared() const { return pools_.use_count() > 1; }
+
+	template<typename U>
+	bool operator==(const PoolAllocator<U> &alloc) const { return pools_ == alloc.pools_; }
+	template<typename U>
+	bool operator!=(const PoolAllocator<U> &alloc) const { return pools_ != alloc.pools_; }
+
+protected:
+	std::shared_ptr<PoolAllocatorPools> pools_;
+	NodePool<PoolBytes<sizeof(T), alignof(T)>> *pool_; // owned by pools_
+};
+
+
+// true if AllocT has a release() freeing everything it allocated at once, like PoolAllocator
+// containers can then clear trivially destructible elements without visiting every node
+template<typename AllocT, typename = void>
+struct AllocatorReleases : std::false_type {};
+
+template<typename AllocT>
+struct AllocatorReleases<AllocT, std::void_t<decltype(std::declval<AllocT &>().release())>> : std::true_type {};
+
+
+
+template<typename T>
+inline NodePool<T>::NodePool()
+	: slabs_(nullptr), slabCount_(0), freeList_(nullptr), freeCount_(0),
+	  unused_(nullptr), unusedEnd_(nullptr), nextSlabSize_(NODEPOOL_FIRST_SLAB_SIZE)
+{}
+
+template<typename T>
+inline NodePool<T>::~NodePool() {
+	clear();
+}
+
+
+
+template<typename T>
+void NodePool<T>::addSlab_(std::size_t size) {
+	while (unused_ != unusedEnd_) {
+		unused_->next = freeList_;
+		freeList_ = unused_++;
+		freeCount_++;
+	}
+
+	Slab *slab = static_cast<Slab *>(::operator new(headerSize_() + size * sizeof(Slot)));
+	slab->next = slabs_;
+	slab->size = size;
+	slabs_ = slab;
+	slabCount_++;
+
+	unused_ = slots_(slab);
+	unusedEnd_ = unused_ + size;
+
+	if (nextSlabSize_ <= size)
+		nextSlabSize_ = size * 2;
+}
+
+
+
+template<typename T>
+inline T * NodePool<T>::allocate() {
+	Slot *slot;
+	if (freeList_ != nullptr) {
+		slot = freeList_;
+		freeList_ = slot->next;
+		freeCount_--;
+	}
+	else {
+		if (unused_ == unusedEnd_)
+			addSlab_(nextSlabSize_);
+		slot = unused_++;
+	}
+	return reinterpret_cast<T *>(slot->storage);
+}
+
+template<typename T>
+inline void NodePool<T>::deallocate(T *node) {
+	Slot *slot = reinterpret_cast<Slot *>(node);
+	slot->next = freeList_;
+	freeList_ = slot;
+	freeCount_++;
+}
+
+template<typename T>
+inline void NodePool<T>::reserve(std::size_t nodes) {
+	std::size_t free = available();
+	if (free < nodes)
+		addSlab_((nextSlabSize_ > nodes - free) ? nextSlabSize_ : nodes - free);
+}
+
+template<typename T>
+void NodePool<T>::clear() {
+	while (slabs_ != nullptr) {
+		Slab *temp = slabs_;
+		slabs_ = slabs_->next;
+		::operator delete(temp);
+	}
+	slabCount_ = 0;
+	freeList_ = nullptr;
+	freeCount_ = 0;
+	unused_ = unusedEnd_ = nullptr;
+	nextSlabSize_ = NODEPOOL_FIRST_SLAB_SIZE;
+}
+
+template<typename T>
+inline void NodePool<T>::swap(NodePool &pool) {
+	std::swap(slabs_, pool.slabs_);
+	std::swap(slabCount_, pool.slabCount_);
+	std::swap(freeList_, pool.freeList_);
+	std::swap(freeCount_, pool.freeCount_);
+	std::swap(unused_, pool.unused_);
+	std::swap(unusedEnd_, pool.unusedEnd_);
+	std::swap(nextSlabSize_, pool.nextSlabSize_);
+}
+
+template<typename T>
+inline std::size_t NodePool<T>::available() const {
+	return freeCount_ + (unusedEnd_ - unused_);
+}
+
+template<typename T>
+inline std::size_t NodePool<T>::slabs() const {
+	return slabCount_;
+}
+
+
+
+inline PoolAllocatorPools::~PoolAllocatorPools() {
+	for (Entry &e : pools_)
+		e.destroy(e.pool);
+}
+
+template<std::size_t Size, std::size_t Align>
+NodePool<PoolBytes<Size, Align>> * PoolAllocatorPools::pool() {
+	typedef NodePool<PoolBytes<Size, Align>> PoolT;
+
+	for (const Entry &e : pools_) {
+		if (e.size == Size && e.align == Align)
+			return static_cast<PoolT *>(e.pool);
+	}
+
+	// room is made first so the new pool cant leak if the list fails to grow
+	pools_.reserve(pools_.size() + 1);
+	PoolT *pool = new PoolT();
+	pools_.push_back(Entry{ Size, Align, pool, [](void *p) { delete static_cast<PoolT *>(p); } });
+	return pool;
+}
+
+
+
+template<typename T>
+inline T * PoolAllocator<T>::allocate(std::size_t n) {
+	if (n == 1)
+		return reinterpret_cast<T *>(pool_->allocate());
+	return static_cast<T *>(::operator new(n * sizeof(T)));
+}
+
+template<typename T>
+inline void PoolAllocator<T>::deallocate(T *p, std::size_t n) {
+	if (n == 1)
+		pool_->deallocate(reinterpret_cast<PoolBytes<sizeof(T), alignof(T)> *>(p));
+	else
+		::operator delete(p);
+}
@@ -0,0 +1,87 @@
+// Concurrent Hashmap Benchmark
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// throughput of ConcurrentHashMap against a ChainedHashMap behind one mutex, for several read/write mixes
+// and thread counts. every thread runs the same number of operations on random keys, writes are half
+// inserts and half removes, so the map stays about half full
+//
+// g++ -std=c++17 -O2 -pthread tests/concurrenthashmapbench.cpp -o concurrenthashmapbench && ./concurrenthashmapbench
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../hashmap/chainedhashmap.h"
+#include "../hashmap/concurrenthashmap.h"
+
+const unsigned KEYS = 1 << 16;
+const unsigned OPS_PER_THREAD = 400000;
+
+// ChainedHashMap with every operation under one lock
+struct LockedMap {
+	std::mutex lock;
+	ChainedHashMap<unsigned, unsigned> map;
+
+	LockedMap() : map(2 * KEYS) {}
+
+	bool find(unsigned key, unsigned &out) {
+		std::lock_guard<std::mutex> guard(lock);
+		const unsigned *data = map.find(key);
+		if (data != nullptr)
+			out = *data;
+		return data != nullptr;
+	}
+	void insert(unsigned key, unsigned data) { std::lock_guard<std::mutex> guard(lock); map.insert(key, data); }
+	void remove(unsigned key) { std::lock_guard<std::mutex> guard(lock); map.remove(key); }
+};
+
+// operations per second of threads running a mix with readPercent reads
+template<typename MapT>
+double throughput(MapT &map, unsigned threads, unsigned readPercent) {
+	for (unsigned key = 0; key < KEYS; key += 2)
+		map.insert(key, key);
+
+	std::vector<std::thread> workers;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (unsigned t = 0; t < threads; t++) {
+		workers.emplace_back([&map, t, readPercent]() {
+			std::mt19937 rng(t + 1);
+			unsigned found = 0, data;
+			for (unsigned i = 0; i < OPS_PER_THREAD; i++) {
+				unsigned key = rng() % KEYS, roll = rng() % 100;
+				if (roll < readPercent)
+					found += map.find(key, data);
+				else if (roll % 2)
+					map.insert(key, key);
+				else
+					map.remove(key);
+			}
+			volatile unsigned sink = found;
+			(void)sink;
+		});
+	}
+	for (std::thread &worker : workers)
+		worker.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return threads * OPS_PER_THREAD / seconds;
+}
+
+int main() {
+	std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+	for (unsigned readPercent : { 100u, 90u, 50u }) {
+		for (unsigned threads : { 1u, 2u, 4u, 8u }) {
+			ConcurrentHashMap<unsigned, unsigned> concurrent(2 * KEYS);
+			LockedMap locked;
+			double a = throughput(concurrent, threads, readPercent);
+			double b = throughput(locked, threads, readPercent);
+			std::printf("%3u%% reads, %u threads: ConcurrentHashMap %5.1fM ops/s, mutex + ChainedHashMap %5.1fM ops/s\n",
+				readPercent, threads, a / 1e6, b / 1e6);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,58 @@
+// Graph Tests
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// g++ -std=c++17 tests/graphtest.cpp graph/graph.cpp graph/pointTypes.cpp graph/frozengraph.cpp -o graphtest && ./graphtest
+
+#include <cassert>
+#include <iostream>
+#include <unordered_set>
+#include "../graph/graph.h"
+#include "../graph/frozengraph.h"
+
+// a grid centered on the origin, so half its coordinates are negative
+static void freezeNegativeGrid() {
+	const int half = 100;
+	Graph graph;
+	for (int x = -half; x < half; x++)
+		for (int y = -half; y < half; y++)
+			graph.insert(Point2D(x, y));
+
+	for (int x = -half; x < half; x++) {
+		for (int y = -half; y < half; y++) {
+			if (x + 1 < half)
+				graph.link(Point2D(x, y), Point2D(x + 1, y));
+			if (y + 1 < half)
+				graph.link(Point2D(x, y), Point2D(x, y + 1));
+		}
+	}
+
+	// points that differ only in sign must not share hashes
+	std::unordered_set<std::size_t> hashes;
+	for (int x = -half; x < half; x++)
+		for (int y = -half; y < half; y++)
+			hashes.insert(std::hash<Point2D>()(Point2D(x, y)));
+	assert(hashes.size() == (std::size_t)(4 * half * half));
+
+	FrozenGraph frozen = graph.freeze();
+	assert(frozen.size() == (unsigned)(4 * half * half));
+
+	std::vector<bool> seen(frozen.size(), false);
+	for (int x = -half; x < half; x++) {
+		for (int y = -half; y < half; y++) {
+			int id = frozen.idOf(Point2D(x, y));
+			assert(id >= 0 && id < (int)frozen.size() && !seen[id]);
+			assert(frozen.pointOf((unsigned)id) == Point2D(x, y));
+			seen[id] = true;
+		}
+	}
+	assert(frozen.idOf(Point2D(half, 0)) == -1 && frozen.idOf(Point2D(-half - 1, -half - 1)) == -1);
+
+	std::vector<PointT> path = frozen.pathfindDijkstra(Point2D(-half, -half), Point2D(half - 1, half - 1));
+	assert(path.size() == (std::size_t)(4 * half - 1));
+}
+
+int main() {
+	freezeNegativeGrid();
+	std::cout << "graph tests passed" << std::endl;
+	return 0;
+}
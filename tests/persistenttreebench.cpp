@@ -0,0 +1,96 @@
+// Persistent Binary Search Tree Benchmark
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// reader and writer throughput of PersistentSearchTree against a SearchTree behind one mutex
+// several reader threads look up random keys while one writer inserts and removes random keys,
+// each run lasts a fixed time and reports operations per second for the readers combined and the writer
+//
+// g++ -std=c++17 -O2 -pthread tests/persistenttreebench.cpp -o persistenttreebench && ./persistenttreebench
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../binsearchtree/persistenttree.h"
+#include "../binsearchtree/tree.h"
+
+const unsigned KEYS = 1 << 16;
+const std::chrono::milliseconds RUN_TIME(1000);
+
+// SearchTree with every operation under one lock
+struct LockedTree {
+	std::mutex lock;
+	SearchTree<unsigned> tree;
+
+	int find(unsigned key) { std::lock_guard<std::mutex> guard(lock); return tree.find(key); }
+	bool insert(unsigned key) { std::lock_guard<std::mutex> guard(lock); return tree.insert(key); }
+	bool remove(unsigned key) { std::lock_guard<std::mutex> guard(lock); return tree.remove(key); }
+};
+
+struct Throughput {
+	double reads, writes; // operations per second
+};
+
+template<typename TreeT>
+Throughput throughput(TreeT &tree, unsigned readers) {
+	for (unsigned key = 0; key < KEYS; key += 2)
+		tree.insert(key);
+
+	std::atomic<bool> stop(false);
+	std::atomic<unsigned long long> reads(0);
+	unsigned long long writes = 0;
+	std::vector<std::thread> threads;
+
+	for (unsigned t = 0; t < readers; t++) {
+		threads.emplace_back([&tree, &stop, &reads, t]() {
+			std::mt19937 rng(t + 1);
+			unsigned long long ops = 0;
+			int found = 0;
+			while (!stop.load(std::memory_order_relaxed)) {
+				found += tree.find(rng() % KEYS) >= 0;
+				ops++;
+			}
+			reads += ops;
+			volatile int sink = found;
+			(void)sink;
+		});
+	}
+	threads.emplace_back([&tree, &stop, &writes]() {
+		std::mt19937 rng(0);
+		while (!stop.load(std::memory_order_relaxed)) {
+			unsigned key = rng() % KEYS;
+			if (key % 2)
+				tree.insert(key);
+			else
+				tree.remove(key);
+			writes++;
+		}
+	});
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::this_thread::sleep_for(RUN_TIME);
+	stop = true;
+	for (std::thread &thread : threads)
+		thread.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return { reads / seconds, writes / seconds };
+}
+
+int main() {
+	std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+	for (unsigned readers : { 1u, 2u, 4u, 8u }) {
+		PersistentSearchTree<unsigned> persistent;
+		LockedTree locked;
+		Throughput a = throughput(persistent, readers);
+		Throughput b = throughput(locked, readers);
+		std::printf("%u readers + 1 writer: PersistentSearchTree %5.2fM reads/s %5.2fM writes/s, "
+			"mutex + SearchTree %5.2fM reads/s %5.2fM writes/s\n",
+			readers, a.reads / 1e6, a.writes / 1e6, b.reads / 1e6, b.writes / 1e6);
+	}
+	return 0;
+}
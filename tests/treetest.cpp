@@ -0,0 +1,81 @@
+// Search Tree Tests
+// Written by ItsNorin      https://github.com/ItsNorin/
+//
+// g++ -std=c++17 -pthread tests/treetest.cpp -o treetest && ./treetest
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <vector>
+#include "../binsearchtree/tree.h"
+#include "../binsearchtree/intervaltree.h"
+
+// iterators to elements still in the tree stay valid across remove, even to a removed node's successor
+static void iteratorSurvivesRemove() {
+	SearchTree<int> tree = { 1, 2, 3, 4, 5, 6, 7 };
+
+	SearchTree<int>::Iterator it = tree.lowerBound(5);
+	assert(tree.remove(4));
+	assert(*it == 5);
+	assert(*it.next() == 6 && *it.prev() == 3);
+
+	// every element keeps its iterator while the others are removed around it
+	std::vector<SearchTree<int>::Iterator> its;
+	for (SearchTree<int>::Iterator i = tree.start(); i != tree.end(); ++i)
+		its.push_back(i);
+
+	for (int key : { 2, 6, 1 })
+		tree.remove(key);
+	for (SearchTree<int>::Iterator i : its)
+		if (*i == 3 || *i == 5 || *i == 7)
+			assert(tree.lowerBound(*i) == i);
+}
+
+// random inserts and removes against std::set, checking order, indices and the interval tree's aggregate
+static void removeKeepsTreeValid() {
+	SearchTree<int> tree;
+	IntervalTree<int> intervals;
+	std::set<int> expected;
+	std::srand(1);
+
+	for (int round = 0; round < 20000; round++) {
+		int key = std::rand() % 512;
+		if (std::rand() % 2) {
+			assert(tree.insert(key) == expected.insert(key).second);
+			intervals.insert(key, key + key % 7);
+		}
+		else {
+			bool removed = tree.remove(key);
+			assert(removed == (expected.erase(key) == 1));
+			assert(intervals.remove(key, key + key % 7) == removed);
+		}
+
+		if (round % 97 != 0)
+			continue;
+
+		assert(tree.size() == (int)expected.size());
+		int i = 0;
+		SearchTree<int>::Iterator it = tree.start();
+		for (int k : expected) {
+			assert(*it == k && tree[i] == k && tree.find(k) == i);
+			++it;
+			i++;
+		}
+		assert(it == tree.end());
+
+		for (int point = 0; point < 520; point += 13) {
+			bool stabbed = false;
+			for (int k : expected)
+				stabbed = stabbed || (k <= point && point <= k + k % 7);
+			assert(intervals.stabs(point) == stabbed);
+		}
+	}
+}
+
+int main() {
+	iteratorSurvivesRemove();
+	removeKeepsTreeValid();
+	std::cout << "tree tests passed" << std::endl;
+	return 0;
+}